@@ -1,5 +1,6 @@
 #ifndef GROUP_MANAGER_H
 #define GROUP_MANAGER_H
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -13,8 +14,9 @@ private:
     GroupManager(const GroupManager&) = delete;
     GroupManager& operator=(const GroupManager&) = delete;
     std::mutex mutex_;  // 保护路由表
-    // 核心路由表 群号->set-用户表
-    std::unordered_map<int, std::unordered_set<std::string>> group_map_;
+    using MemberSet = std::unordered_set<std::string>;
+    // 核心路由表 群号->set-用户表；名单不可变，读者拿共享指针不用整份拷贝
+    std::unordered_map<int, std::shared_ptr<const MemberSet>> group_map_;
 
 public:
     // 1、单例模型
@@ -24,8 +26,9 @@ public:
     }
     // 2、初始化 --将群成员加载在内存中
     void InitLoadFromDB();
-    // 3、获取成员名字
-    std::unordered_set<std::string> GetGroupMembers(int group_id);
+    // 3、获取成员名字（不存在的群返回空名单，不会是空指针）
+    std::shared_ptr<const std::unordered_set<std::string>> GetGroupMembers(
+        int group_id);
     // 4、判断成员是否在群
     bool IsUserInGroup(int group_id, const std::string& username);
 };
@@ -3,6 +3,8 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <memory>
 #include "network/Connection.h"
 class UserManager {
@@ -19,6 +21,13 @@ public:
     void AddUser(const std::string &username, std::shared_ptr<Connection> conn);
     void RemoveUser(const std::string &username);
     std::weak_ptr<Connection> GetConnection(const std::string &username);
-    void CheckTimeouts(int timeout_seconds);
+    // 一次加锁查一批用户：在线的放进 online，不在线的放进 offline，跳过 exclude
+    void GetConnections(const std::unordered_set<std::string> &usernames,
+                        const std::string &exclude,
+                        std::vector<std::shared_ptr<Connection>> &online,
+                        std::vector<std::string> &offline);
+    // 一次加锁查一批用户是否在线，online[i] 对应 usernames[i]
+    void GetPresence(const std::vector<std::string> &usernames,
+                     std::vector<bool> &online);
 };
 #endif
\ No newline at end of file
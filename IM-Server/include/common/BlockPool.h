@@ -0,0 +1,59 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// 按大小分级的内存块池：64B 到 64KB，每级是 2 的幂。
+// 每个线程一份空闲链表（loop 线程就是 per-loop），不加锁；
+// 本线程缓存空了从全局仓库批量取，缓存太多时一半还回全局仓库，
+// 所以在A线程分配、B线程释放（连接在accept线程建、在工作线程析构）也能循环起来。
+// 超过 64KB 的直接走 operator new。
+class BlockPool {
+public:
+    static const size_t kMinBlock = 64;
+    static const size_t kMaxBlock = 64 * 1024;
+
+    static void *Allocate(size_t size);
+    // size 必须和 Allocate 时一样（或者同一级）
+    static void Deallocate(void *ptr, size_t size);
+    // size 所在级别的实际块大小，调用方可以把多出来的空间用掉
+    static size_t BlockSize(size_t size);
+
+    struct Stats {
+        uint64_t hits = 0;      // 从线程缓存或全局仓库拿到（各线程攒批上报，略有滞后）
+        uint64_t misses = 0;    // 池里没有，新分配
+        uint64_t refills = 0;   // 线程缓存从全局仓库批量补货的次数
+        uint64_t oversize = 0;  // 超过最大级别、不走池的分配
+        uint64_t cached_bytes = 0;  // 全局仓库里闲置的字节
+    };
+    static Stats GetStats();
+};
+
+// 让 allocate_shared / 容器从 BlockPool 分配：
+// allocate_shared<Connection>(PoolAllocator<Connection>(), ...) 把控制块和对象
+// 放在同一个池块里，一次分配
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(BlockPool::Allocate(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) noexcept {
+        BlockPool::Deallocate(ptr, n * sizeof(T));
+    }
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const noexcept {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const noexcept {
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,16 @@
+#ifndef COARSE_CLOCK_H
+#define COARSE_CLOCK_H
+#include <atomic>
+#include <ctime>
+
+// 所有loop共享的粗粒度时钟（秒）：由各loop的定时器tick刷新，
+// 热路径上读一次原子变量代替每条消息调用 time(NULL)
+class CoarseClock {
+public:
+    static time_t Now() { return now_.load(std::memory_order_relaxed); }
+    static void Update() { now_.store(time(NULL), std::memory_order_relaxed); }
+
+private:
+    static std::atomic<time_t> now_;
+};
+#endif
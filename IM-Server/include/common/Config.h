@@ -11,6 +11,70 @@ public:
     bool Load(const std::string &config_file);
     std::string GetServerIp() const { return server_ip_; }
     uint16_t GetServerPort() const { return server_port_; }
+    // 子reactor线程数，0表示单reactor
+    size_t GetIoThreads() const { return io_threads_; }
+    // 新连接分配策略：round_robin / least_connections
+    std::string GetBalancePolicy() const { return balance_policy_; }
+    // listen 队列长度
+    int GetBacklog() const { return backlog_; }
+    // SO_REUSEPORT 监听分片数，0表示只有一个监听socket
+    size_t GetReuseportShards() const { return reuseport_shards_; }
+    // 分片模式下是否绑核并按CPU引流
+    bool GetCpuSteering() const { return cpu_steering_; }
+    // 心跳超时秒数
+    int GetHeartbeatTimeout() const { return heartbeat_timeout_; }
+    // 发送合并方式：none / msg_more / tcp_cork
+    std::string GetCorkMode() const { return cork_mode_; }
+    // IO多路复用后端：epoll / io_uring
+    std::string GetPoller() const { return poller_; }
+    // 连接fd的注册方式：level / edge / oneshot
+    std::string GetTriggerMode() const { return trigger_mode_; }
+    // 阻塞IO线程池 / 计算线程池的线程数，0 表示取 CPU 核数
+    size_t GetBlockingThreads() const { return blocking_threads_; }
+    size_t GetCpuThreads() const { return cpu_threads_; }
+    // 日志：目录、文件名前缀、级别、是否打开逐事件trace
+    std::string GetLogDir() const { return log_dir_; }
+    std::string GetLogBase() const { return log_base_; }
+    std::string GetLogLevel() const { return log_level_; }
+    bool GetLogTrace() const { return log_trace_; }
+    // 包体压缩：开关、阈值（字节）、LZ4加速因子、统计日志间隔（秒）
+    bool GetCompressEnable() const { return compress_enable_; }
+    size_t GetCompressThreshold() const { return compress_threshold_; }
+    int GetCompressAcceleration() const { return compress_acceleration_; }
+    int GetCompressStatsInterval() const { return compress_stats_interval_; }
+    // 慢消费者保护：单连接高/低水位、硬上限、全局预算（字节）和策略
+    size_t GetFlowHighWater() const { return flow_high_water_; }
+    size_t GetFlowLowWater() const { return flow_low_water_; }
+    size_t GetFlowHardLimit() const { return flow_hard_limit_; }
+    size_t GetFlowGlobalBudget() const { return flow_global_budget_; }
+    std::string GetFlowPolicy() const { return flow_policy_; }
+    // 接入：一次最多接入的连接数、每秒限速（0 不限）、令牌桶容量
+    size_t GetAcceptBatch() const { return accept_batch_; }
+    double GetAcceptRate() const { return accept_rate_; }
+    double GetAcceptBurst() const { return accept_burst_; }
+    // 连接socket选项：预设（default / low_latency）和逐项设置，含义见 SocketOptions
+    std::string GetSocketPreset() const { return socket_preset_; }
+    bool GetSocketNoDelay() const { return socket_no_delay_; }
+    int GetSocketSendBuf() const { return socket_send_buf_; }
+    int GetSocketRecvBuf() const { return socket_recv_buf_; }
+    bool GetSocketQuickAck() const { return socket_quick_ack_; }
+    int GetSocketBusyPoll() const { return socket_busy_poll_us_; }
+    int GetSocketUserTimeout() const { return socket_user_timeout_ms_; }
+    bool GetSocketKeepalive() const { return socket_keepalive_; }
+    int GetSocketKeepaliveIdle() const { return socket_keepalive_idle_; }
+    int GetSocketKeepaliveInterval() const { return socket_keepalive_interval_; }
+    int GetSocketKeepaliveCount() const { return socket_keepalive_count_; }
+    // 收发loop的自适应忙轮询窗口（微秒），0 关闭
+    int GetLoopSpin() const { return loop_spin_us_; }
+    // 平滑重启：交接监听socket的 Unix socket 路径（空为关闭，默认关）、排空连接的秒数。
+    // 开的话放在只有服务账号能写的目录里，例如 /run/im_server/upgrade.sock，
+    // 不要放 /tmp 这种谁都能建文件的地方
+    std::string GetUpgradePath() const { return upgrade_path_; }
+    int GetDrainTimeout() const { return drain_timeout_; }
+    // 指标抓取端口（Prometheus 文本格式），端口 0 表示不开（默认）。
+    // 开的话 ip 保持 127.0.0.1 只给本机的采集进程抓，端口例如 9100
+    std::string GetAdminIp() const { return admin_ip_; }
+    int GetAdminPort() const { return admin_port_; }
 
     // 【新增】获取数据库配置
     std::string GetDbHost() const { return db_host_; }
@@ -26,6 +90,49 @@ private:
     Config &operator=(const Config &) = delete;
     std::string server_ip_;
     uint16_t server_port_;
+    size_t io_threads_ = 0;
+    std::string balance_policy_ = "round_robin";
+    int backlog_ = 128;
+    size_t reuseport_shards_ = 0;
+    bool cpu_steering_ = false;
+    int heartbeat_timeout_ = 30;
+    std::string cork_mode_ = "none";
+    std::string poller_ = "epoll";
+    std::string trigger_mode_ = "level";
+    size_t blocking_threads_ = 4;
+    size_t cpu_threads_ = 0;
+    std::string log_dir_ = ".";
+    std::string log_base_ = "app";
+    std::string log_level_ = "info";
+    bool log_trace_ = false;
+    bool compress_enable_ = true;
+    size_t compress_threshold_ = 512;
+    int compress_acceleration_ = 1;
+    int compress_stats_interval_ = 60;
+    size_t flow_high_water_ = 1024 * 1024;
+    size_t flow_low_water_ = 256 * 1024;
+    size_t flow_hard_limit_ = 8 * 1024 * 1024;
+    size_t flow_global_budget_ = 256 * 1024 * 1024;
+    std::string flow_policy_ = "drop_oldest";
+    size_t accept_batch_ = 64;
+    double accept_rate_ = 0;
+    double accept_burst_ = 0;
+    std::string socket_preset_ = "default";
+    bool socket_no_delay_ = true;
+    int socket_send_buf_ = 0;
+    int socket_recv_buf_ = 0;
+    bool socket_quick_ack_ = false;
+    int socket_busy_poll_us_ = 0;
+    int socket_user_timeout_ms_ = 0;
+    bool socket_keepalive_ = false;
+    int socket_keepalive_idle_ = 60;
+    int socket_keepalive_interval_ = 10;
+    int socket_keepalive_count_ = 3;
+    int loop_spin_us_ = 0;
+    std::string upgrade_path_;
+    int drain_timeout_ = 30;
+    std::string admin_ip_ = "127.0.0.1";
+    int admin_port_ = 0;
 
     // 【新增】数据库私有变量
     std::string db_host_;
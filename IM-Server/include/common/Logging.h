@@ -0,0 +1,61 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+#include <atomic>
+#include <string>
+
+#include "Log.h"  // MyLog：双缓冲队列 + 后台线程写文件
+
+// 服务端日志层：业务/IO线程只格式化一条 LogEntry 推进 MyLog 的 AsyncQueue，
+// 写文件由后台线程批量完成，不再抢 stdout 的锁。
+//
+// TRACE 是逐事件/逐包的跟踪日志：
+//   编译期 IM_LOG_TRACE_COMPILED=0 时整行消失；
+//   编译进来时受运行期开关控制，关闭状态下只多一次 relaxed 原子读。
+//   开关本身就是过滤条件，打开后按 INFO 级别写出，不受 level 阈值影响。
+#ifndef IM_LOG_TRACE_COMPILED
+#define IM_LOG_TRACE_COMPILED 1
+#endif
+
+struct ServerLogOptions {
+    std::string dir = ".";
+    std::string base = "app";
+    std::string level = "info";  // debug / info / warn / error
+    bool trace = false;
+    uint64_t max_bytes = 100ull << 20;
+};
+
+class ServerLog {
+public:
+    static void Init(const ServerLogOptions &options);
+    static bool TraceEnabled() {
+        return trace_enabled_.load(std::memory_order_relaxed);
+    }
+    // 运行期开关，可以在信号处理函数里调用（只写一个原子变量）
+    static void SetTraceEnabled(bool enabled) {
+        trace_enabled_.store(enabled, std::memory_order_relaxed);
+    }
+    // 刷完队列里剩下的日志，退出前调用
+    static void Shutdown();
+
+private:
+    static std::atomic<bool> trace_enabled_;
+};
+
+#define IM_DEBUG(fmt, ...) LOG_DEBUG(Logger::instance(), fmt, ##__VA_ARGS__)
+#define IM_INFO(fmt, ...) LOG_INFO(Logger::instance(), fmt, ##__VA_ARGS__)
+#define IM_WARN(fmt, ...) LOG_WARN(Logger::instance(), fmt, ##__VA_ARGS__)
+#define IM_ERROR(fmt, ...) LOG_ERROR(Logger::instance(), fmt, ##__VA_ARGS__)
+
+#if IM_LOG_TRACE_COMPILED
+#define IM_TRACE(fmt, ...)                                      \
+    do {                                                        \
+        if (ServerLog::TraceEnabled()) {                        \
+            IM_INFO("[trace] " fmt, ##__VA_ARGS__);             \
+        }                                                       \
+    } while (0)
+#else
+#define IM_TRACE(fmt, ...) \
+    do {                   \
+    } while (0)
+#endif
+#endif
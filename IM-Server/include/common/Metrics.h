@@ -0,0 +1,170 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 指标库：记录路径只有一次 relaxed 原子加，不加锁。
+//   每个线程第一次记录时分到一个分片，计数加在自己分片的缓存行上，
+//   读的时候（抓取，很少发生）再把各分片加起来。
+//   注册和渲染加锁，只在启动和抓取时发生
+
+// 分片数；线程多于分片时几个线程共用一个分片，只是多一点缓存行争用
+static const size_t kMetricShards = 16;
+
+// 当前线程的分片下标，第一次调用时轮流分配
+size_t MetricShard();
+
+// 微秒级单调时钟，给延迟直方图用
+inline uint64_t MetricNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+struct alignas(64) MetricCell {
+    std::atomic<int64_t> value{0};
+};
+
+// 只增不减的计数
+class Counter {
+public:
+    void Inc(int64_t n = 1) {
+        cells_[MetricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    int64_t Value() const;
+
+private:
+    MetricCell cells_[kMetricShards];
+};
+
+// 可以多线程加减的量，例如当前在处理的请求数
+class Gauge {
+public:
+    void Add(int64_t n) {
+        cells_[MetricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    void Sub(int64_t n) { Add(-n); }
+    int64_t Value() const;
+
+private:
+    MetricCell cells_[kMetricShards];
+};
+
+// HDR 风格的对数-线性直方图：每个 2 的幂区间再等分 8 个桶，相对误差不超过 12.5%，
+// 量程 0 ~ 2^40，超出的记在最后一个桶。值的单位由使用者定（延迟用微秒）
+class Histogram {
+public:
+    static const int kSubBits = 3;
+    static const int kMaxBits = 40;
+    // 0 单独一个桶
+    static const size_t kBuckets = 1 + ((kMaxBits - kSubBits + 1) << kSubBits);
+
+    Histogram();
+    void Record(uint64_t value) {
+        Shard &shard = shards_[MetricShard()];
+        shard.counts[BucketIndex(value)].fetch_add(1,
+                                                   std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;  // 各桶计数
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        // 不超过 value 的记录数
+        uint64_t CountAtMost(uint64_t value) const;
+        // 分位数（桶的上界），没有记录时返回 0
+        uint64_t Quantile(double q) const;
+    };
+    Snapshot Collect() const;
+
+    // 桶 i 收的是 (BucketUpper(i-1), BucketUpper(i)] 里的值
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpper(size_t index);
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counts[kBuckets];
+        std::atomic<uint64_t> sum;
+    };
+    std::unique_ptr<Shard[]> shards_;
+};
+
+// 统计一段代码的耗时（微秒）记进直方图
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Histogram *histogram)
+        : histogram_(histogram), start_us_(MetricNowUs()) {}
+    ~ScopedLatency() { histogram_->Record(MetricNowUs() - start_us_); }
+    ScopedLatency(const ScopedLatency &) = delete;
+    ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+private:
+    Histogram *histogram_;
+    uint64_t start_us_;
+};
+
+// 全局注册表。Get* 按 名字+标签 返回同一个对象，指针在进程内一直有效，
+// 热路径上把指针存成静态变量或成员，之后不再经过注册表。
+// 标签写成 Prometheus 的形式，例如 "op=\"check_user\""
+class MetricsRegistry {
+public:
+    static MetricsRegistry &GetInstance();
+
+    Counter *GetCounter(const std::string &name, const std::string &help,
+                        const std::string &labels = "");
+    Gauge *GetGauge(const std::string &name, const std::string &help,
+                    const std::string &labels = "");
+    // scale：导出时每个单位乘的系数，微秒记录、按秒导出就是 1e-6
+    Histogram *GetHistogram(const std::string &name, const std::string &help,
+                            const std::string &labels = "",
+                            double scale = 1.0);
+    // 抓取时才调用的回调，用来导出已经在别处统计着的数（各loop连接数、内存池）。
+    // 同名同标签再注册会替换掉之前的回调
+    using ValueFunc = std::function<double()>;
+    void AddCounterFunc(const std::string &name, const std::string &help,
+                        const std::string &labels, ValueFunc func);
+    void AddGaugeFunc(const std::string &name, const std::string &help,
+                      const std::string &labels, ValueFunc func);
+
+    // Prometheus 文本格式（0.0.4）。直方图按 4 的幂给出累计桶，
+    // 另外导出 <name>_quantile{quantile="0.5|0.99|0.999"}
+    std::string Render() const;
+
+private:
+    enum class Type { kCounter, kGauge, kHistogram };
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        ValueFunc func;
+    };
+    struct Family {
+        Type type;
+        std::string help;
+        double scale = 1.0;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+    // 调用方持锁
+    Series *FindOrAdd(const std::string &name, const std::string &help,
+                      const std::string &labels, Type type, double scale);
+    static void RenderHistogram(const std::string &name, const Family &family,
+                                const Series &series, std::string &out);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;  // 按名字排序输出
+};
+#endif
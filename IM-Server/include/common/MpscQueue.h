@@ -0,0 +1,62 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+#include <atomic>
+#include <thread>
+#include <utility>
+
+// 多生产者单消费者无锁队列（Vyukov 链表式）。
+// Push 任意线程调用，只有一次原子 exchange；Pop 只能由唯一的消费者线程调用。
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load()) {}
+    ~MpscQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+        delete tail_;
+    }
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void Push(T value) {
+        Node *node = new Node(std::move(value));
+        Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 队列为空返回 false。生产者 exchange 之后、挂链之前的极短窗口里
+    // 会原地等它挂好，所以已经 Push 返回的元素一定能被取到
+    bool Pop(T &value) {
+        Node *tail = tail_;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            if (head_.load(std::memory_order_acquire) == tail) return false;
+            while ((next = tail->next.load(std::memory_order_acquire)) ==
+                   nullptr) {
+                std::this_thread::yield();
+            }
+        }
+        value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+    // 只给消费者线程用的近似判断
+    bool Empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr &&
+               head_.load(std::memory_order_acquire) == tail_;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+        T value;
+        std::atomic<Node *> next{nullptr};
+    };
+    std::atomic<Node *> head_;  // 生产者端
+    Node *tail_;                // 消费者端（哨兵）
+};
+#endif
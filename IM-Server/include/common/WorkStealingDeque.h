@@ -0,0 +1,120 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev 工作窃取双端队列（按 Lê 等人的 C11 内存序版本实现）。
+// 只有所属线程能 Push/Pop（从底部，LIFO，热数据留在本核缓存）；
+// 其他线程用 Steal 从顶部偷（FIFO）。T 必须是可平凡拷贝的，一般放指针。
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "WorkStealingDeque stores T in atomics");
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256)
+        : top_(0), bottom_(0) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        Array *array = new Array(cap);
+        arrays_.emplace_back(array);
+        array_.store(array, std::memory_order_relaxed);
+    }
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // 所属线程调用，满了就翻倍扩容
+    void Push(T item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Array *array = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(array->capacity) - 1) {
+            array = Grow(array, t, b);
+        }
+        array->Put(b, item);
+        // release 发布元素，和 Steal 里对 bottom_ 的 acquire 配对
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // 所属线程调用，空了返回 false
+    bool Pop(T &item) {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array *array = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = array->Get(b);
+        if (t == b) {
+            // 只剩最后一个，和窃取者抢
+            bool won = top_.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // 任意线程调用；失败（空或者和别人抢输了）返回 false
+    bool Steal(T &item) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Array *array = array_.load(std::memory_order_acquire);
+        T value = array->Get(t);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        item = value;
+        return true;
+    }
+
+    // 近似值，只用来判断要不要去偷/要不要睡
+    size_t Size() const {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+    bool Empty() const { return Size() == 0; }
+
+private:
+    struct Array {
+        explicit Array(size_t cap)
+            : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+        T Get(int64_t i) const {
+            return slots[i & mask].load(std::memory_order_relaxed);
+        }
+        void Put(int64_t i, T value) {
+            slots[i & mask].store(value, std::memory_order_relaxed);
+        }
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array *Grow(Array *old, int64_t t, int64_t b) {
+        Array *array = new Array(old->capacity * 2);
+        for (int64_t i = t; i < b; ++i) array->Put(i, old->Get(i));
+        // 旧数组可能还有窃取者在读，留到析构时一起释放
+        arrays_.emplace_back(array);
+        array_.store(array, std::memory_order_release);
+        return array;
+    }
+
+    alignas(64) std::atomic<int64_t> top_;     // 窃取端
+    alignas(64) std::atomic<int64_t> bottom_;  // 所属线程端
+    std::atomic<Array *> array_;
+    std::vector<std::unique_ptr<Array>> arrays_;  // 只有所属线程改
+};
+#endif
@@ -0,0 +1,84 @@
+#ifndef ACCEPTOR_H
+#define ACCEPTOR_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "network/Channel.h"
+#include "network/EventLoop.h"
+#include "network/SocketOptions.h"
+#include "network/TimerWheel.h"
+
+struct AcceptorOptions {
+    // 一次可读事件最多接入的连接数，剩下的交给下一轮（水平触发还会报）
+    size_t batch = 64;
+    // 每秒最多接入的连接数，0 不限；分片时平均分给每个监听socket
+    double rate = 0;
+    // 令牌桶容量（允许的突发），0 时取一秒的量
+    double burst = 0;
+    // 接入后立即设置到连接fd上
+    SocketOptions socket;
+};
+
+// 一个监听socket一个Acceptor，只在所属loop线程使用：
+//   accept4 直接拿到非阻塞、CLOEXEC 的fd，一次可读事件里成批接入，
+//   交出去之前先设置好 SocketOptions；
+//   fd 用完（EMFILE/ENFILE）时让出预留的空闲fd，接下来再关掉，让对端立刻感知，
+//   而不是让连接留在队列里、监听socket一直可读、loop空转；
+//   令牌桶限速：令牌用完就停止关注可读，下个tick补充令牌后再恢复，
+//   来不及接的连接留在内核的 accept 队列里，重连风暴时不会挤占已建立连接的处理时间。
+// 监听socket归调用方所有，Acceptor 不关闭它
+class Acceptor {
+public:
+    using NewConnectionCallback = std::function<void(int fd)>;
+    Acceptor(EventLoop *loop, int listen_fd, const AcceptorOptions &options);
+    ~Acceptor();
+    Acceptor(const Acceptor &) = delete;
+    Acceptor &operator=(const Acceptor &) = delete;
+
+    void SetNewConnectionCallback(NewConnectionCallback cb) {
+        new_connection_callback_ = std::move(cb);
+    }
+    // 在所属loop线程调用，开始接入
+    void Listen();
+    // 在所属loop线程调用，停止接入（监听socket交给新进程之后），之后不再有回调
+    void Stop();
+    EventLoop *GetLoop() const { return loop_; }
+
+    // 所有Acceptor累计，任意线程可读
+    struct Stats {
+        uint64_t accepted = 0;
+        uint64_t shed = 0;       // fd 不够时接了就关的连接
+        uint64_t throttled = 0;  // 令牌用完暂停接入的次数
+        uint64_t fd_paused = 0;  // fd 用完又没有预留fd可让，暂停接入的次数
+    };
+    static Stats GetStats();
+
+private:
+    void HandleRead();
+    // 让出预留fd接一个连接马上关掉，再把预留fd占回来
+    void ShedOne();
+    // 按经过的时间补充令牌
+    void Refill();
+    // 停到下一个tick再接；out_of_fds 区分是fd耗尽还是限速，分开计数
+    void Pause(bool out_of_fds);
+    void Resume();
+
+    EventLoop *loop_;
+    int listen_fd_;
+    Channel channel_;
+    AcceptorOptions options_;
+    NewConnectionCallback new_connection_callback_;
+    int idle_fd_;  // fd 用完时让出来的预留fd
+    double tokens_;
+    int64_t last_refill_ms_;
+    TimerNode resume_timer_;
+    time_t last_shed_log_ = 0;
+
+    static std::atomic<uint64_t> accepted_;
+    static std::atomic<uint64_t> shed_;
+    static std::atomic<uint64_t> throttled_;
+    static std::atomic<uint64_t> fd_paused_;
+};
+#endif
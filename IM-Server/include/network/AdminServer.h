@@ -0,0 +1,59 @@
+#ifndef ADMIN_SERVER_H
+#define ADMIN_SERVER_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "network/Channel.h"
+#include "network/EventLoop.h"
+#include "network/TimerWheel.h"
+
+// 管理端口：只认 GET /metrics（或 GET /），回 Prometheus 文本格式的
+// MetricsRegistry::Render()，回完就关。挂在主loop上，和业务连接完全分开，
+// 同时最多接待 kMaxClients 个抓取方，多的直接关掉。
+// 监听socket开了 SO_REUSEPORT，平滑重启时新旧进程可以同时绑定；
+// 旧进程让位后调 Stop()，之后的抓取都落到新进程
+class AdminServer {
+public:
+    AdminServer(EventLoop *loop, const std::string &ip, uint16_t port);
+    ~AdminServer();
+    AdminServer(const AdminServer &) = delete;
+    AdminServer &operator=(const AdminServer &) = delete;
+
+    // 在loop线程调用，绑定失败返回 false（不影响主服务）
+    bool Start();
+    // 在loop线程调用：关掉监听socket和所有抓取连接
+    void Stop();
+
+private:
+    struct Client {
+        int fd = -1;
+        std::unique_ptr<Channel> channel;
+        std::string request;
+        std::string response;
+        size_t sent = 0;
+        TimerNode idle_timer;  // 一直发不完整请求或者不收响应的，超时关掉
+        // 关掉之后本批就绪事件里可能还有它的，回调见到这个标志直接返回
+        bool closed = false;
+    };
+    static const size_t kMaxClients = 16;
+    static const size_t kMaxRequest = 8192;
+    static const int kIdleTicks = 5;
+
+    void HandleAccept();
+    void HandleClient(Client *client, uint32_t revents);
+    // 请求头收齐了，生成响应开始写
+    void Respond(Client *client);
+    // 写完返回 true
+    bool WriteResponse(Client *client);
+    void CloseClient(Client *client);
+
+    EventLoop *loop_;
+    std::string ip_;
+    uint16_t port_;
+    int listen_fd_ = -1;
+    std::unique_ptr<Channel> listen_channel_;
+    std::unordered_map<int, std::unique_ptr<Client>> clients_;
+};
+#endif
@@ -0,0 +1,113 @@
+#ifndef BODY_CODEC_H
+#define BODY_CODEC_H
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/json.hpp"
+
+// 包体格式。包头 msg_type 带 Codec::kBinaryBody 标志位的是二进制，否则是JSON
+enum class BodyFormat { kJson, kBinary };
+
+// 字段编号。二进制里是 TLV 的 tag，JSON 里对应 kFieldNames 里的键名
+enum class Field : uint8_t {
+    kCmd = 1,       // 命令，二进制里是 Cmd 的编号
+    kCode = 2,      // 回包状态码
+    kMsg = 3,       // 文本内容
+    kUsername = 4,
+    kPassword = 5,
+    kTo = 6,
+    kFrom = 7,
+    kGroupId = 8,
+    kUsers = 9,     // 可重复
+    kTime = 10,
+    kStatus = 11,   // 可重复，每个是 {用户名, 是否在线}
+    kBinary = 12,   // 登录时声明：之后的推送用二进制
+    kCompress = 13, // 登录时声明能解压；回包里带上表示服务端同意
+    kMaxField
+};
+
+// 命令编号，JSON 里对应 cmd 字符串
+enum class Cmd : uint8_t {
+    kUnknown = 0,
+    kLogin = 1,
+    kLoginResp = 2,
+    kChat = 3,
+    kGroupChat = 4,
+    kPushChat = 5,
+    kPushGroupChat = 6,
+    kPresence = 7,
+    kPresenceResp = 8,
+    kMaxCmd
+};
+
+// 二进制包体：一串字段，每个字段
+//   varint(field << 3 | wire_type) + 值
+//   wire_type 0：varint 整数；2：varint 长度 + 字节
+// 不认识的字段直接跳过，新增字段不影响老服务端。
+namespace varint {
+void Append(std::string &out, uint64_t value);
+// 成功返回消耗的字节数，数据不完整或超过10字节返回0
+size_t Read(std::string_view in, uint64_t &value);
+}  // namespace varint
+
+// 读请求包体，不管哪种格式都用同一套接口取字段。
+// 二进制不建DOM，字段值直接指向包体（包体要比 reader 活得久）；
+// JSON 作为兜底仍然解析成 DOM
+class BodyReader {
+public:
+    // 解析失败（JSON语法错、二进制截断）返回 false
+    bool Parse(BodyFormat format, std::string_view body);
+    BodyFormat Format() const { return format_; }
+
+    Cmd GetCmd() const;
+    // 字段缺失或类型不对返回空串 / default_value
+    std::string_view GetString(Field field) const;
+    int64_t GetInt(Field field, int64_t default_value = 0) const;
+    bool GetBool(Field field) const { return GetInt(field, 0) != 0; }
+    bool Has(Field field) const;
+    // 可重复字段（如 users）。JSON 里字段缺失或不是数组返回 false
+    bool GetStrings(Field field, std::vector<std::string_view> &values) const;
+    // 文本字段都是合法 UTF-8。JSON 解析时已经校验过；二进制的字节原样指向包体，
+    // 转发给 JSON 接收方之前必须先查，否则编码时会抛异常
+    bool TextValid() const;
+
+private:
+    struct Value {
+        bool present = false;
+        bool is_int = false;
+        uint64_t number = 0;
+        std::string_view bytes;
+    };
+    BodyFormat format_ = BodyFormat::kJson;
+    std::string_view body_;
+    std::array<Value, static_cast<size_t>(Field::kMaxField)> fields_;
+    nlohmann::json json_;
+};
+
+// 写回包/推送包体，按格式选择编码
+class BodyWriter {
+public:
+    explicit BodyWriter(BodyFormat format) : format_(format) {}
+    BodyWriter &SetCmd(Cmd cmd);
+    BodyWriter &SetInt(Field field, int64_t value);
+    BodyWriter &SetString(Field field, std::string_view value);
+    // kStatus 这类 名字->布尔 的条目，可多次调用
+    BodyWriter &AddStatus(Field field, std::string_view name, bool value);
+    // 没有条目时 JSON 也要输出空对象；二进制里就是没有这个字段
+    BodyWriter &SetEmptyMap(Field field);
+
+    // 打成完整的包，二进制会在 msg_type 上带标志位；
+    // compress 为 true 且包体够大时压缩并带上 Codec::kCompressed
+    std::string Pack(uint32_t msg_type, bool compress = false) const;
+    std::string Body() const;
+
+private:
+    BodyFormat format_;
+    std::string binary_;
+    nlohmann::json json_ = nlohmann::json::object();
+};
+#endif
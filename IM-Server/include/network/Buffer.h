@@ -1,31 +1,91 @@
 #ifndef BUFFER_H
 #define BUFFER_H
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstring>
 #include <string>
 
+#include "common/BlockPool.h"
+
+// muduo 风格缓冲区：
+// +-------------------+------------------+------------------+
+// | prependable bytes |  readable bytes  |  writable bytes  |
+// +-------------------+------------------+------------------+
+// 0          reader_index_      writer_index_           size()
+// 取数据只移动 reader_index_，不再每次 erase 搬动后面的数据；
+// 空间不够时先把可读数据挪回前面复用，实在不够才扩容。
+// 存储从 BlockPool 按级别取，连接断开后块回到池里给下一个连接用。
 class Buffer {
 public:
-    Buffer() = default;
-    ~Buffer() = default;
+    static const size_t kCheapPrepend = 8;  // 预留给包头
+    static const size_t kInitialSize = 1024;
+    static const size_t kExtraBufSize = 65536;  // ReadFd 的栈上扩展区
+
+    explicit Buffer(size_t initial_size = kInitialSize)
+        : capacity_(BlockPool::BlockSize(kCheapPrepend + initial_size)),
+          data_(static_cast<char *>(BlockPool::Allocate(capacity_))),
+          reader_index_(kCheapPrepend),
+          writer_index_(kCheapPrepend) {}
+    ~Buffer() { BlockPool::Deallocate(data_, capacity_); }
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
 
     // 往buffer放数据
     void Append(const char *data, size_t len);
     // 获取buffer所有数据
     std::string RetrieveAllAsString();
     // 查看buffer有多少数据
-    size_t ReadableBytes() const;
+    size_t ReadableBytes() const { return writer_index_ - reader_index_; }
+    size_t WritableBytes() const { return capacity_ - writer_index_; }
+    size_t PrependableBytes() const { return reader_index_; }
     // 查看数据
-    const char *Peek() const { return buf_.data(); }
+    const char *Peek() const { return Begin() + reader_index_; }
     // 拿走指定长度的数据
     void Retrieve(size_t len) {
-        if (len <= buf_.size()) buf_.erase(0, len);
+        if (len < ReadableBytes()) {
+            reader_index_ += len;
+        } else {
+            RetrieveAll();
+        }
+    }
+    void RetrieveAll() {
+        reader_index_ = kCheapPrepend;
+        writer_index_ = kCheapPrepend;
     }
     std::string RetrieveAsString(size_t len) {
-        std::string result(buf_.data(), len);
+        std::string result(Peek(), len);
         Retrieve(len);
         return result;
     }
+    // 在可读数据前面插入（例如补包头），要求 len <= PrependableBytes()
+    void Prepend(const void *data, size_t len) {
+        reader_index_ -= len;
+        const char *d = static_cast<const char *>(data);
+        std::copy(d, d + len, Begin() + reader_index_);
+    }
+
+    // 供 read() 直接写入：先 EnsureWritable，写完再 HasWritten
+    char *BeginWrite() { return Begin() + writer_index_; }
+    const char *BeginWrite() const { return Begin() + writer_index_; }
+    void EnsureWritable(size_t len) {
+        if (WritableBytes() < len) MakeSpace(len);
+    }
+    void HasWritten(size_t len) { writer_index_ += len; }
+
+    // 用一次 readv 从fd读数据：先填可写区，溢出部分落在64KB栈缓冲再追加进来。
+    // buffer 平时保持小，只有真来了大数据才扩容。返回 read 的返回值，
+    // 出错时 errno 存进 saved_errno
+    ssize_t ReadFd(int fd, int *saved_errno);
 
 private:
-    std::string buf_;
+    char *Begin() { return data_; }
+    const char *Begin() const { return data_; }
+    void MakeSpace(size_t len);
+
+    size_t capacity_;
+    char *data_;
+    size_t reader_index_;
+    size_t writer_index_;
 };
-#endif
\ No newline at end of file
+#endif
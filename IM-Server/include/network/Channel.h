@@ -0,0 +1,81 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+#include <sys/epoll.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+class EventLoop;
+
+// fd 的注册方式：
+//   kLevel   水平触发，没处理完的下一轮还会报
+//   kEdge    边缘触发（EPOLLET），每次就绪必须读/写到 EAGAIN，否则不会再报
+//   kOneShot EPOLLONESHOT，报一次就在内核里停掉，回调结束后由 EventLoop 重新挂上
+enum class TriggerMode { kLevel, kEdge, kOneShot };
+// "level" / "edge" / "oneshot"，不认识的按 level
+TriggerMode ParseTriggerMode(const std::string &name);
+const char *TriggerModeName(TriggerMode mode);
+
+// 一个fd对应一个Channel：记住关注的事件和回调。
+// 注册时Poller记下Channel指针（epoll 放在 data.ptr 里），就绪后直接拿指针分发，
+// 不再查 fd->回调 的表。Channel 不拥有 fd，只在所属loop线程里使用。
+class Channel {
+public:
+    using EventCallback = std::function<void(uint32_t)>;
+    using FlushCallback = std::function<void()>;
+    Channel(EventLoop *loop, int fd);
+    ~Channel() = default;
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    // 由EventLoop在事件就绪时调用
+    void HandleEvent(uint32_t revents) { event_callback_(revents); }
+    void SetEventCallback(EventCallback cb) { event_callback_ = std::move(cb); }
+    // 本轮循环末尾统一flush时调用（见 EventLoop::MarkDirty）
+    void HandleFlush() { flush_callback_(); }
+    void SetFlushCallback(FlushCallback cb) { flush_callback_ = std::move(cb); }
+
+    // 修改关注事件：只交给Poller更新注册，不重新分配回调
+    void EnableReading() { events_ |= EPOLLIN; Update(); }
+    void DisableReading() { events_ &= ~EPOLLIN; Update(); }
+    void EnableWriting() { events_ |= EPOLLOUT; Update(); }
+    // 边缘触发下一次把读写都挂上，之后不再切换
+    void EnableReadWrite() { events_ |= EPOLLIN | EPOLLOUT; Update(); }
+    void DisableWriting() { events_ &= ~EPOLLOUT; Update(); }
+    void DisableAll() { events_ = 0; Update(); }
+    bool IsWriting() const { return events_ & EPOLLOUT; }
+    bool IsReading() const { return events_ & EPOLLIN; }
+    // 从Poller中摘除，之后不会再收到回调
+    void Remove();
+
+    int Fd() const { return fd_; }
+    // 关注的事件（EPOLLIN/EPOLLOUT），不含触发方式的标志位
+    uint32_t Events() const { return events_; }
+    // 注册前设置，默认水平触发
+    TriggerMode Mode() const { return mode_; }
+    void SetTriggerMode(TriggerMode mode) { mode_ = mode; }
+    // 单次触发的fd报过事件、还没重新挂上时为 false（Poller维护）
+    bool IsArmed() const { return armed_; }
+    void SetArmed(bool armed) { armed_ = armed; }
+    // 是否已经注册到Poller（Poller维护）
+    bool IsAdded() const { return added_; }
+    void SetAdded(bool added) { added_ = added; }
+    // 是否已经在loop的待flush列表里（EventLoop维护）
+    bool IsDirty() const { return dirty_; }
+    void SetDirty(bool dirty) { dirty_ = dirty; }
+
+private:
+    void Update();
+
+    EventLoop *loop_;
+    const int fd_;
+    uint32_t events_;
+    TriggerMode mode_;
+    bool added_;
+    bool armed_;
+    bool dirty_;
+    EventCallback event_callback_;
+    FlushCallback flush_callback_;
+};
+#endif
@@ -1,15 +1,38 @@
 #ifndef CODEC_H
 #define CODEC_H
 #include <string>
+#include <string_view>
 
+#include "network/BodyCodec.h"
 #include "network/Buffer.h"
 #include "network/Protocol.h"
 
 class Codec {
 public:
+    // 包头 msg_type 的高位是标志位，低位才是真正的消息类型
+    static const uint32_t kFlagMask = 0xFF000000u;  // 高8位留给标志位
+    static const uint32_t kBinaryBody = 1u << 30;   // 包体是二进制TLV
+    static const uint32_t kCompressed = 1u << 31;   // 包体经过压缩（Compressor）
+
+    // 一个完整的包：body 直接指向 buffer 内部，不做拷贝。
+    // 只在 RetrieveFrame / 再次往 buffer 写入之前有效
+    struct Frame {
+        uint32_t msg_type = 0;  // 已去掉标志位
+        uint32_t flags = 0;
+        std::string_view body;
+        BodyFormat Format() const {
+            return (flags & kBinaryBody) ? BodyFormat::kBinary
+                                         : BodyFormat::kJson;
+        }
+    };
+    // buffer 里有完整包时填好 frame 并返回 true，不移动读指针
+    static bool PeekFrame(const Buffer *buffer, Frame &frame);
+    // 把 PeekFrame 看到的包从 buffer 里取走（只移动读指针）
+    static void RetrieveFrame(Buffer *buffer, const Frame &frame);
+
     static bool ParseMessage(Buffer *buffer, uint32_t &out_msg_type,
                              std::string &out_msg_body);
     static std::string PackMessage(uint32_t msg_type,
                                    const std::string &msg_body);
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,72 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+struct CompressOptions {
+    bool enable = true;
+    size_t threshold = 512;  // 包体小于这个字节数不压缩
+    int acceleration = 1;    // LZ4 加速因子，越大越快、压缩率越低
+    int stats_interval = 60; // 统计日志间隔（秒），0 表示不打
+};
+
+// 包体压缩（LZ4 块格式），头部 msg_type 带 Codec::kCompressed 标志位。
+// 压缩后的包体 = 4字节大端原始长度 + LZ4 块。
+// 编译时没找到 liblz4（没有 IM_HAVE_LZ4）就永远不压缩，收到压缩包按坏包处理。
+// 任意线程可调用，计数器都是 relaxed 原子量
+class Compressor {
+public:
+    // 解压后包体的上限，防止一个小包声称自己解开有几个G
+    static const size_t kMaxRawLength = 16 * 1024 * 1024;
+
+    static Compressor &GetInstance();
+    void Init(const CompressOptions &options);
+    // 编进来了且配置打开
+    bool Available() const;
+
+    // body 达到阈值且压完确实变小才原地替换并返回 true
+    bool Compress(std::string &body);
+    // 数据损坏、长度不符、超过上限返回 false
+    bool Decompress(std::string_view in, std::string &out);
+
+    struct Stats {
+        uint64_t compressed = 0;      // 压缩发出的帧数
+        uint64_t skipped_small = 0;   // 低于阈值没压的
+        uint64_t skipped_ratio = 0;   // 压了但没变小，按原样发的
+        uint64_t raw_bytes = 0;       // 压缩帧压缩前的总字节数
+        uint64_t packed_bytes = 0;    // 压缩帧压缩后的总字节数
+        uint64_t compress_ns = 0;     // 压缩耗时（含没变小的）
+        uint64_t decompressed = 0;
+        uint64_t decompress_ns = 0;
+        uint64_t decompress_errors = 0;
+    };
+    Stats GetStats() const;
+
+private:
+    Compressor() = default;
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+    // 到了统计间隔就打一行日志，多个线程同时到只有一个打
+    void MaybeReport();
+
+    bool enable_ = true;
+    size_t threshold_ = 512;
+    int acceleration_ = 1;
+    int stats_interval_ = 60;
+
+    std::atomic<uint64_t> compressed_{0};
+    std::atomic<uint64_t> skipped_small_{0};
+    std::atomic<uint64_t> skipped_ratio_{0};
+    std::atomic<uint64_t> raw_bytes_{0};
+    std::atomic<uint64_t> packed_bytes_{0};
+    std::atomic<uint64_t> compress_ns_{0};
+    std::atomic<uint64_t> decompressed_{0};
+    std::atomic<uint64_t> decompress_ns_{0};
+    std::atomic<uint64_t> decompress_errors_{0};
+    std::atomic<time_t> next_report_{0};
+};
+#endif
@@ -1,37 +1,131 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
+#include <atomic>
 #include <ctime>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "common/BlockPool.h"
+#include "common/CoarseClock.h"
+#include "network/BodyCodec.h"
 #include "network/Buffer.h"
+#include "network/Channel.h"
 #include "network/EventLoop.h"
-#include "network/ThreadPool.h"
+#include "network/OutputQueue.h"
+#include "network/Strand.h"
+#include "network/TimerWheel.h"
 class Connection : public std::enable_shared_from_this<Connection> {
 public:
     using CloseCallback = std::function<void(uint32_t)>;
+    // fd 必须已经是非阻塞的（Acceptor 用 accept4 直接拿到）
     Connection(EventLoop *loop, int fd);
     ~Connection();
 
+    // 在所属loop线程里调用：把fd注册进epoll，开始收发
+    void ConnectEstablished();
+    // 在所属loop线程里调用：从epoll摘掉fd，之后不再有任何回调
+    void ConnectDestroyed();
+    EventLoop *GetLoop() const { return loop_; }
+    int GetFd() const { return fd_; }
+
     // 核心：当epoll 发现有数据可读时，调用该函数
     void Read();
-    // 核心：给客户端发消息
-    void Send(const std::string &msg);
+    // 核心：给客户端发消息（任意线程可调用，实际发送在所属loop线程）
+    void Send(std::string msg);
+    // 发送已经打包好的共享帧，不拷贝
+    void Send(PacketPtr packet);
+    // 把同一个帧发给一批连接：按所属loop分组，每个loop只投递一次。
+    // 广播的帧在接收方发送队列里是可丢弃的（见 FlowControl）
+    static void Broadcast(const std::vector<std::shared_ptr<Connection>> &conns,
+                          const PacketPtr &packet);
 
     void SetCloseCallback(const CloseCallback &cb) { close_callback_ = cb; }
+    // 登录成功后绑定的用户名，未登录为空。
+    // 只在本连接的 Strand 上读写（登录、业务处理、断开清理都在上面串行执行）
+    const std::string &GetUser() const { return current_user_; }
+    void SetUser(const std::string &username) { current_user_ = username; }
+    // 推送给本连接时用的包体格式，登录时协商；其他连接的任务也会读
+    BodyFormat PushFormat() const {
+        return binary_push_.load(std::memory_order_relaxed)
+                   ? BodyFormat::kBinary
+                   : BodyFormat::kJson;
+    }
+    void SetPushFormat(BodyFormat format) {
+        binary_push_.store(format == BodyFormat::kBinary,
+                           std::memory_order_relaxed);
+    }
+    // 推送/回包是否可以压缩，登录时协商
+    bool CompressPush() const {
+        return compress_push_.load(std::memory_order_relaxed);
+    }
+    void SetCompressPush(bool on) {
+        compress_push_.store(on, std::memory_order_relaxed);
+    }
+    // 本连接的业务任务都经由它投递，保证按收包顺序执行
+    Strand &GetStrand() { return *strand_; }
     // 获取最后活跃时间
     time_t GetLastActiveTime() const { return last_active_time_; }
-    // 更新活跃时间（只要收到任何数据就调用)
-    void UpdateActiveTime() { last_active_time_ = time(NULL); }
+    // 心跳超时秒数，0 表示不检测；在 ConnectEstablished 之前设置
+    void SetIdleTimeout(int seconds) { idle_timeout_ = seconds; }
+    // 一次flush要分多次写时的合并方式；在 ConnectEstablished 之前设置
+    void SetCorkMode(CorkMode mode) { cork_mode_ = mode; }
+    // fd 的注册方式（见 TriggerMode）；在 ConnectEstablished 之前设置
+    void SetTriggerMode(TriggerMode mode) { channel_.SetTriggerMode(mode); }
+    // 每次读完都重新打开 TCP_QUICKACK；在 ConnectEstablished 之前设置
+    void SetQuickAck(bool on) { quick_ack_ = on; }
+    // 更新活跃时间（只要收到任何数据就调用)：读共享粗时钟，
+    // 超时定时器在时间轮上挪个槽，同一个tick内重复调用什么都不做
+    void UpdateActiveTime() {
+        last_active_time_ = CoarseClock::Now();
+        if (idle_timeout_ > 0) {
+            loop_->GetTimerWheel().Refresh(&idle_timer_, IdleTimeoutTicks());
+        }
+    }
     // 统一事件分发器
     void HandleEvent(uint32_t revents);
-    // 异步写函数
+    // 把发送队列尽量写出去（EPOLLOUT 或有新数据时调用）
     void Write();
+    // 任意线程可调用：在所属loop上把能写的先写出去，再关掉连接。
+    // 平滑重启时旧进程分批关连接，让客户端重连到新进程
+    void Shutdown();
 
 private:
+    // 单次可读事件最多读入的字节数
+    static const size_t kMaxReadPerWakeup = 256 * 1024;
+
+    bool EdgeTriggered() const {
+        return channel_.Mode() == TriggerMode::kEdge;
+    }
+    // 在loop线程只入队并标记dirty，本轮循环末尾统一flush一次
+    void SendInLoop(PacketPtr packet, bool droppable = false);
+    // 待发字节过了高水位（或全局预算超了）时按策略处理
+    void CheckHighWater();
+    // 写出去之后回到低水位就恢复读
+    void CheckLowWater();
+    // 把读缓冲区里完整的包逐个分发；暂停读时停下
+    void ProcessFrames();
+    // 待发字节的变化同步到全局预算
+    void SyncOutputBudget();
+    // 慢消费者被踢：和心跳超时一样关掉
+    void ForceClose(const char *reason);
+    // loop 末尾的flush回调
+    void Flush();
+    // 连接断开的统一出口：清理在线状态并通知TcpServer，只执行一次
+    void HandleClose();
+    // 心跳超时：在所属loop上真正关掉连接
+    void HandleIdleTimeout();
+    uint64_t IdleTimeoutTicks() const {
+        return (static_cast<uint64_t>(idle_timeout_) * 1000 +
+                EventLoop::kTickMs - 1) /
+               EventLoop::kTickMs;
+    }
+
     EventLoop *loop_;
     int fd_;
+    // 直接嵌在连接里，不单独分配
+    Channel channel_;
     Buffer read_buffer_;
     CloseCallback close_callback_;
     // 未来要加的：用户登陆绑定的ID
@@ -39,10 +133,23 @@ private:
     // 【新增 2】：记住当前这个连接登录成功的用户名
     std::string current_user_;
     // 记录最后一次收到包的时间
-    time_t last_active_time_;
+    time_t last_active_time_ = 0;
+    int idle_timeout_ = 0;
+    TimerNode idle_timer_;
+    std::shared_ptr<Strand> strand_;
+    std::atomic<bool> binary_push_{false};
+    std::atomic<bool> compress_push_{false};
 
-    // 写缓冲的锁与写缓冲
-    std::mutex send_mutex_;
-    std::string write_buffer_;
+    // 发送队列，只在loop线程访问
+    OutputQueue output_queue_;
+    CorkMode cork_mode_ = CorkMode::kNone;
+    size_t budgeted_bytes_ = 0;  // 已经记到全局预算里的待发字节
+    // 内核发送缓冲区满了、在等可写事件。水平触发时和关注 EPOLLOUT 一致；
+    // 边缘触发一直关注 EPOLLOUT，只能靠这个标志
+    bool write_blocked_ = false;
+    bool read_paused_ = false;   // 因为发送积压暂停了读
+    bool quick_ack_ = false;
+    bool closed_ = false;
+    bool handed_over_ = false;  // 平滑重启时由 Shutdown 关掉，不同步 Redis 下线
 };
 #endif
\ No newline at end of file
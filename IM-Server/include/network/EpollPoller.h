@@ -0,0 +1,27 @@
+#ifndef EPOLL_POLLER_H
+#define EPOLL_POLLER_H
+#include <sys/epoll.h>
+
+#include "network/Poller.h"
+
+// epoll 后端（默认）：Channel 指针放进 epoll_event.data.ptr，就绪后直接分发。
+// 三种触发方式都支持，单次触发的fd报过一次就标记为未挂上，由 EventLoop 重新挂
+class EpollPoller : public Poller {
+public:
+    EpollPoller();
+    ~EpollPoller() override;
+    EpollPoller(const EpollPoller &) = delete;
+    EpollPoller &operator=(const EpollPoller &) = delete;
+
+    int Poll(int timeout_ms, std::vector<Event> &active) override;
+    void UpdateChannel(Channel *channel) override;
+    void RemoveChannel(Channel *channel) override;
+    const char *Name() const override { return "epoll"; }
+    bool SupportsMode(TriggerMode) const override { return true; }
+
+private:
+    static const int MAX_EVENTS = 1024;
+    int epoll_fd_;
+    struct epoll_event events_[MAX_EVENTS];  // 接受就绪事件
+};
+#endif
@@ -1,33 +1,137 @@
 #ifndef EVENT_LOOP_H
 #define EVENT_LOOP_H
 #include <sys/types.h>
-#include <sys/epoll.h>
 
 // 【补充加在这里】
 
+#include <atomic>
 #include <functional>
-#include <map>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
+
+#include "common/MpscQueue.h"
+#include "network/Channel.h"
+#include "network/Poller.h"
+#include "network/TimerWheel.h"
 class EventLoop {
 public:
-    EventLoop();
+    // poller："epoll" / "io_uring"，见 Poller::Create
+    explicit EventLoop(const std::string &poller = "epoll");
     ~EventLoop();
-    // 定义回调函数
-    using EventCallback = std::function<void(uint32_t)>;
+    using Functor = std::function<void()>;
     // 核心循环
     void Loop();
-    // 将文件描述符添加到监听列表
-    void AddEvent(int fd, uint32_t events, EventCallback cb);
+    // 退出循环（可跨线程调用）
+    void Quit();
+    const char *PollerName() const { return poller_->Name(); }
+    bool SupportsMode(TriggerMode mode) const {
+        return poller_->SupportsMode(mode);
+    }
+    // 自适应忙轮询：最近一次有事件之后，在一个窗口内用 0 超时轮询、不睡眠，
+    // 窗口里一直没有新事件才回到阻塞等待。窗口在 (0, us] 之间自己调整：
+    // 阻塞后很快就等到事件（本可以转着接住）就放大，等了很久（白转）就缩小，
+    // 空闲或稀疏的loop不会白白占着CPU。0 关闭。任意线程可调用，下一轮循环生效
+    void SetBusyPoll(int us) {
+        busy_poll_us_.store(us, std::memory_order_relaxed);
+    }
+    // 按Channel当前关注的事件注册/修改监听，只在loop线程调用
+    void UpdateChannel(Channel *channel);
     // 移除监听
-    void RemoveEvent(int fd);
+    void RemoveChannel(Channel *channel);
+
+    // 在loop线程中执行cb：本线程直接执行，其他线程则入队并唤醒
+    void RunInLoop(Functor cb);
+    // 入队，等本轮事件处理完再执行。任意线程可调用：
+    // 无锁入队，每轮循环最多触发一次 eventfd 唤醒
+    void QueueInLoop(Functor cb);
+    // 标记channel有待发数据，本轮事件和任务都处理完后统一调它的flush回调一次，
+    // 同一轮里的多次发送合并成一次写。只在loop线程调用
+    void MarkDirty(Channel *channel);
+    // 本loop的时间轮，只在loop线程使用；1 tick = kTickMs 毫秒
+    static const int kTickMs = 1000;
+    TimerWheel &GetTimerWheel() { return timer_wheel_; }
+
+    bool IsInLoopThread() const {
+        return thread_id_ == std::this_thread::get_id();
+    }
+
+    // 收发路径的系统调用计数：除 wakeups 外都是loop线程单写，其他线程可以读
+    struct IoStats {
+        std::atomic<uint64_t> flushes{0};      // 统一flush的连接次数
+        std::atomic<uint64_t> write_calls{0};  // sendmsg 次数
+        std::atomic<uint64_t> packets{0};      // 写完的包数
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> bytes_in{0};     // 从连接读到的字节
+        std::atomic<uint64_t> frames{0};       // 收到的完整包数
+        std::atomic<uint64_t> polls{0};        // Poll 返回次数（loop 醒来的次数）
+        std::atomic<uint64_t> wakeups{0};      // 其他线程写 eventfd 叫醒的次数
+        std::atomic<uint64_t> ctl_calls{0};    // 改注册的次数，见 Poller::CtlCalls
+        std::atomic<uint64_t> busy_polls{0};   // 忙轮询时空手而归的次数
+    };
+    const IoStats &GetIoStats() const { return io_stats_; }
+    // 只在loop线程调用
+    void RecordWrite(size_t calls, size_t packets, size_t bytes);
+    void RecordFrames(size_t frames);
+    void RecordRead(size_t bytes);
+
+    // 该loop上挂着的连接数（给least-connections策略用）
+    size_t ConnectionCount() const {
+        return connection_count_.load(std::memory_order_relaxed);
+    }
+    void IncConnectionCount() {
+        connection_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void DecConnectionCount() {
+        connection_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
 
 private:
-    int epoll_fd_;
-    static const int MAX_EVENTS = 1024;
-    struct epoll_event events_[MAX_EVENTS];  // 接受就绪事件
-    bool quit_;
+    // eventfd 唤醒
+    void Wakeup();
+    void HandleWakeup();
+    // timerfd 到期：刷新共享时钟并推进时间轮
+    void HandleTimer();
+    // 执行跨线程投递过来的任务
+    void DoPendingFunctors();
+    // 调用本轮被 MarkDirty 的channel的flush回调
+    void FlushDirty();
+    // 每隔一段时间打一行发送统计
+    void ReportIoStats();
+    // 根据本轮 Poll 的结果调整忙轮询窗口
+    void AdaptBusyPoll(int timeout_ms, int busy_poll_us);
+
+    std::unique_ptr<Poller> poller_;
+    std::vector<Poller::Event> active_events_;  // 每轮的就绪事件，复用内存
+    std::atomic<bool> quit_;
+    std::atomic<int> busy_poll_us_{0};
+    int64_t last_active_us_ = 0;  // 上一次拿到事件的时刻，忙轮询用
+    int spin_window_us_ = 0;      // 当前的忙轮询窗口
+    const std::thread::id thread_id_;  // loop所属线程
+
+    int wakeup_fd_;
+    std::unique_ptr<Channel> wakeup_channel_;
+    MpscQueue<Functor> pending_functors_;
+    // 已经写过 eventfd、loop 还没来得及处理，其他生产者就不必再写
+    std::atomic<bool> wakeup_pending_;
+
+    int timer_fd_;
+    std::unique_ptr<Channel> timer_channel_;
+    TimerWheel timer_wheel_;
+    std::atomic<size_t> connection_count_;
 
-    // 保存fd与回调函数的映射
-    std::map<int, EventCallback> callbacks_;
+    // 待flush的channel；flushing_ 是正在处理的那一批，两者交换复用内存
+    std::vector<Channel *> dirty_channels_;
+    std::vector<Channel *> flushing_;
+    IoStats io_stats_;
+    uint64_t stats_ticks_ = 0;
+    uint64_t reported_calls_ = 0;
+    uint64_t reported_packets_ = 0;
+    uint64_t reported_frames_ = 0;
+    uint64_t reported_polls_ = 0;
+    uint64_t reported_wakeups_ = 0;
+    uint64_t reported_ctl_calls_ = 0;
+    uint64_t reported_busy_polls_ = 0;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,31 @@
+#ifndef EVENT_LOOP_THREAD_H
+#define EVENT_LOOP_THREAD_H
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "network/EventLoop.h"
+
+// 一个线程跑一个EventLoop（one loop per thread）
+class EventLoopThread {
+public:
+    explicit EventLoopThread(const std::string &poller = "epoll")
+        : poller_(poller) {}
+    ~EventLoopThread();
+    EventLoopThread(const EventLoopThread &) = delete;
+    EventLoopThread &operator=(const EventLoopThread &) = delete;
+
+    // 启动线程，阻塞到loop在新线程里构造完成后返回；cpu>=0 时把线程绑到该CPU
+    EventLoop *StartLoop(int cpu = -1);
+
+private:
+    void ThreadFunc(int cpu);
+
+    std::string poller_;
+    EventLoop *loop_ = nullptr;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+#endif
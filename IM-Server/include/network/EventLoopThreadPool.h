@@ -0,0 +1,33 @@
+#ifndef EVENT_LOOP_THREAD_POOL_H
+#define EVENT_LOOP_THREAD_POOL_H
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network/EventLoop.h"
+#include "network/EventLoopThread.h"
+#include "network/LoadBalancer.h"
+
+// 子reactor池：主loop负责accept，连接分给池里的子loop处理读写
+class EventLoopThreadPool {
+public:
+    EventLoopThreadPool(EventLoop *base_loop, size_t num_threads,
+                        const std::string &policy,
+                        const std::string &poller = "epoll");
+    ~EventLoopThreadPool() = default;
+
+    // pin_cpu 为 true 时第i个线程绑到第i个CPU（超出核数则取模）
+    void Start(bool pin_cpu = false);
+    // 给新连接挑一个loop；没有子线程时返回主loop（单reactor模式）
+    EventLoop *GetNextLoop();
+    const std::vector<EventLoop *> &GetAllLoops() const { return loops_; }
+
+private:
+    EventLoop *base_loop_;
+    size_t num_threads_;
+    std::string poller_;
+    std::unique_ptr<LoadBalancer> balancer_;
+    std::vector<std::unique_ptr<EventLoopThread>> threads_;
+    std::vector<EventLoop *> loops_;
+};
+#endif
@@ -0,0 +1,90 @@
+#ifndef FLOW_CONTROL_H
+#define FLOW_CONTROL_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+// 发送队列超过高水位时怎么处理慢消费者
+enum class SlowConsumerPolicy {
+    kPauseRead,   // 停止读这个连接，写到低水位以下再恢复
+    kDropOldest,  // 丢掉最老的可丢弃推送（群聊推送），直到低水位
+    kDisconnect,  // 直接断开
+};
+
+struct FlowControlOptions {
+    size_t high_water = 1024 * 1024;      // 单连接待发字节的高水位
+    size_t low_water = 256 * 1024;        // 低水位：恢复读 / 丢到这里为止
+    size_t hard_limit = 8 * 1024 * 1024;  // 任何策略下超过就断开
+    // 所有连接待发字节的总预算，超了以后过低水位的连接就按高水位处理。
+    // 群聊共享帧按每个连接各算一份，是偏保守的上界
+    size_t global_budget = 256 * 1024 * 1024;
+    std::string policy = "drop_oldest";  // pause_read / drop_oldest / disconnect
+};
+
+// 慢消费者保护：水位配置、全局发送预算和各策略的计数。
+// 任意线程可调用，计数器都是 relaxed 原子量
+class FlowControl {
+public:
+    static FlowControl &GetInstance();
+    void Init(const FlowControlOptions &options);
+
+    SlowConsumerPolicy Policy() const { return policy_; }
+    size_t HighWater() const { return high_water_; }
+    size_t LowWater() const { return low_water_; }
+    size_t HardLimit() const { return hard_limit_; }
+
+    // 连接的待发字节变化量（可正可负）记进全局账上
+    void Adjust(int64_t delta) {
+        outstanding_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    bool OverBudget() const {
+        return outstanding_.load(std::memory_order_relaxed) >
+               static_cast<int64_t>(global_budget_);
+    }
+
+    void CountPause() { Count(paused_); }
+    void CountResume() { Count(resumed_); }
+    void CountDrop(size_t packets, size_t bytes);
+    void CountDisconnect() { Count(disconnects_); }
+    void CountBudgetHit() { Count(budget_hits_); }
+
+    struct Stats {
+        int64_t outstanding = 0;  // 当前所有连接待发字节
+        uint64_t paused = 0;
+        uint64_t resumed = 0;
+        uint64_t dropped_packets = 0;
+        uint64_t dropped_bytes = 0;
+        uint64_t disconnects = 0;
+        uint64_t budget_hits = 0;  // 因为全局预算超了才触发策略的次数
+    };
+    Stats GetStats() const;
+
+private:
+    FlowControl() = default;
+    FlowControl(const FlowControl &) = delete;
+    FlowControl &operator=(const FlowControl &) = delete;
+    void Count(std::atomic<uint64_t> &counter) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        MaybeReport();
+    }
+    // 有事件发生时最多每 kReportInterval 秒打一行
+    void MaybeReport();
+
+    SlowConsumerPolicy policy_ = SlowConsumerPolicy::kDropOldest;
+    size_t high_water_ = 1024 * 1024;
+    size_t low_water_ = 256 * 1024;
+    size_t hard_limit_ = 8 * 1024 * 1024;
+    size_t global_budget_ = 256 * 1024 * 1024;
+
+    std::atomic<int64_t> outstanding_{0};
+    std::atomic<uint64_t> paused_{0};
+    std::atomic<uint64_t> resumed_{0};
+    std::atomic<uint64_t> dropped_packets_{0};
+    std::atomic<uint64_t> dropped_bytes_{0};
+    std::atomic<uint64_t> disconnects_{0};
+    std::atomic<uint64_t> budget_hits_{0};
+    std::atomic<time_t> next_report_{0};
+};
+#endif
@@ -0,0 +1,85 @@
+#ifndef IO_URING_POLLER_H
+#define IO_URING_POLLER_H
+#ifdef IM_HAVE_IO_URING
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "network/Poller.h"
+
+// io_uring 后端（需要 5.13+ 内核）。直接用系统调用和 mmap 的 SQ/CQ 环，不依赖 liburing。
+// 仍是就绪模型：每个fd挂一个单次的 IORING_OP_POLL_ADD，完成后在下一次等待前重新挂上，
+// 新挂的、改掩码的（原地 poll update）、摘除的请求都攒在 SQ 里，
+// 和等待合成一次 io_uring_enter，一轮循环只进一次内核。
+// 单次 poll 在挂上时就会检查当前状态，所以语义和 epoll 的水平触发一样。
+class IoUringPoller : public Poller {
+public:
+    explicit IoUringPoller(unsigned entries = kDefaultEntries);
+    ~IoUringPoller() override;
+    IoUringPoller(const IoUringPoller &) = delete;
+    IoUringPoller &operator=(const IoUringPoller &) = delete;
+
+    int Poll(int timeout_ms, std::vector<Event> &active) override;
+    void UpdateChannel(Channel *channel) override;
+    void RemoveChannel(Channel *channel) override;
+    const char *Name() const override { return "io_uring"; }
+
+private:
+    // 每个fd一项，下标是fd
+    struct Registration {
+        Channel *channel = nullptr;
+        // 每次换Channel/摘除加一，和fd一起拼成 user_data，旧请求的完成事件据此丢掉
+        uint32_t gen = 0;
+        uint32_t mask = 0;          // 内核里那个 poll 等的掩码
+        bool armed = false;         // 内核里有一个还没取到完成事件的 poll
+        bool rearm_queued = false;  // 已经在 rearm_ 里
+    };
+    static const unsigned kDefaultEntries = 4096;
+    // POLL_REMOVE / poll update 自己的完成事件，不用处理
+    static const uint64_t kInternalTag = ~0ull;
+
+    static uint64_t UserData(int fd, uint32_t gen) {
+        return static_cast<uint64_t>(gen) << 32 | static_cast<uint32_t>(fd);
+    }
+    Registration &Slot(int fd);
+    // 取一个空的sqe，SQ满了先提交一次
+    struct io_uring_sqe *GetSqe();
+    // io_uring_enter：提交攒下的sqe，min_complete>0 时等完成事件
+    int Enter(unsigned min_complete, unsigned flags, void *arg, size_t arg_size);
+    void QueuePollAdd(int fd, Registration &reg);
+    void QueuePollRemove(uint64_t user_data);
+    void QueuePollUpdate(uint64_t user_data, uint32_t mask);
+    void QueueRearm(int fd, Registration &reg);
+    // 把待重挂的fd按Channel当前掩码挂上
+    void ArmPending();
+    // 取走CQ里所有完成事件，返回追加到 active 的个数
+    int Reap(std::vector<Event> &active);
+    void Unmap();
+
+    int ring_fd_;
+    // SQ：sq_tail_local_ 是本地填到哪，提交时才写回共享的 tail
+    unsigned *sq_head_;
+    unsigned *sq_tail_;
+    unsigned *sq_array_;
+    unsigned sq_mask_;
+    unsigned sq_entries_;
+    unsigned sq_tail_local_;
+    struct io_uring_sqe *sqes_;
+    // CQ
+    unsigned *cq_head_;
+    unsigned *cq_tail_;
+    unsigned cq_mask_;
+    struct io_uring_cqe *cqes_;
+    // mmap 出来的区域，FEAT_SINGLE_MMAP 时 SQ/CQ 共用一块
+    void *sq_ring_;
+    size_t sq_ring_size_;
+    void *cq_ring_;
+    size_t cq_ring_size_;
+    size_t sqes_size_;
+
+    std::vector<Registration> registrations_;
+    std::vector<int> rearm_;
+};
+#endif
+#endif
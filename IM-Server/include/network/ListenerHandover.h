@@ -0,0 +1,55 @@
+#ifndef LISTENER_HANDOVER_H
+#define LISTENER_HANDOVER_H
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network/Channel.h"
+#include "network/EventLoop.h"
+
+// 平滑重启时在新旧进程之间交接监听socket（Unix 域socket + SCM_RIGHTS）：
+//   旧进程在 path 上等着；新进程预热完（连库、加载群组）才来领监听socket，
+//   开始 accept 之后回一个确认，旧进程收到确认才停止 accept、开始排空连接。
+//   新进程没确认就退出的话旧进程照常服务。
+//   两边拿到的是同一个内核监听socket，交接前后排在 accept 队列里的连接不会丢
+class ListenerHandover {
+public:
+    // 新进程：连上旧进程领取监听socket，peer_fd 留着之后 Confirm。
+    // 没有旧进程在等（或者超时）返回 false
+    static bool Fetch(const std::string &path, std::vector<int> *fds,
+                      int *peer_fd);
+    // 新进程：已经开始 accept，通知旧进程让位并关闭 peer_fd
+    static void Confirm(int peer_fd);
+
+    // 旧进程：在 loop 上等新进程来领 listen_fds（fd 仍归调用方所有）
+    ListenerHandover(EventLoop *loop, const std::string &path,
+                     const std::vector<int> &listen_fds);
+    ~ListenerHandover();
+    ListenerHandover(const ListenerHandover &) = delete;
+    ListenerHandover &operator=(const ListenerHandover &) = delete;
+
+    // 新进程确认接手后在loop线程调用
+    void SetTakeoverCallback(std::function<void()> cb) {
+        takeover_callback_ = std::move(cb);
+    }
+    // 在loop线程调用：删掉 path 上残留的socket文件，重新绑定并开始等待
+    bool Listen();
+
+private:
+    void HandleAccept();
+    // 新进程的确认或断开
+    void HandlePeer();
+    void ClosePeer();
+    void CloseListener();
+
+    EventLoop *loop_;
+    std::string path_;
+    std::vector<int> listen_fds_;
+    int unix_fd_ = -1;
+    std::unique_ptr<Channel> unix_channel_;
+    int peer_fd_ = -1;  // 正在交接的新进程，同一时间只接待一个
+    std::unique_ptr<Channel> peer_channel_;
+    std::function<void()> takeover_callback_;
+};
+#endif
@@ -0,0 +1,51 @@
+#ifndef LOAD_BALANCER_H
+#define LOAD_BALANCER_H
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network/EventLoop.h"
+
+// 主reactor给新连接挑选子reactor的策略
+class LoadBalancer {
+public:
+    virtual ~LoadBalancer() = default;
+    // loops 非空，返回选中的loop
+    virtual EventLoop *Select(const std::vector<EventLoop *> &loops) = 0;
+    // 按名字创建策略："round_robin" / "least_connections"，未知名字退回轮询
+    static std::unique_ptr<LoadBalancer> Create(const std::string &policy);
+};
+
+// 轮询：只在acceptor线程调用，不需要原子
+class RoundRobinBalancer : public LoadBalancer {
+public:
+    EventLoop *Select(const std::vector<EventLoop *> &loops) override {
+        EventLoop *loop = loops[next_];
+        next_ = (next_ + 1) % loops.size();
+        return loop;
+    }
+
+private:
+    size_t next_ = 0;
+};
+
+// 最少连接：挑当前挂着连接最少的loop，相同则取靠前的
+class LeastConnectionsBalancer : public LoadBalancer {
+public:
+    EventLoop *Select(const std::vector<EventLoop *> &loops) override {
+        EventLoop *best = loops[0];
+        for (EventLoop *loop : loops) {
+            if (loop->ConnectionCount() < best->ConnectionCount()) best = loop;
+        }
+        return best;
+    }
+};
+
+inline std::unique_ptr<LoadBalancer> LoadBalancer::Create(
+    const std::string &policy) {
+    if (policy == "least_connections") {
+        return std::unique_ptr<LoadBalancer>(new LeastConnectionsBalancer());
+    }
+    return std::unique_ptr<LoadBalancer>(new RoundRobinBalancer());
+}
+#endif
@@ -0,0 +1,65 @@
+#ifndef MESSAGE_DISPATCHER_H
+#define MESSAGE_DISPATCHER_H
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "network/Codec.h"
+
+class Connection;
+class Counter;
+
+// 处理函数在哪里执行
+enum class ExecMode {
+    kInline,    // 直接在IO线程执行：必须便宜且不阻塞（ping、在线查询）
+    kCpu,       // 计算线程池
+    kBlocking,  // 阻塞IO线程池（查库、写Redis）
+};
+// kCpu/kBlocking 经由连接的 Strand 投递，同一连接内按收包顺序执行；
+// kInline 不排队，可能跑在同一连接尚未执行完的异步任务前面
+
+// frame.body 在 kInline 时直接指向读缓冲区，只在本次调用内有效；
+// 投递到线程池时 body 已经拷贝进任务里。frame.Format() 是请求的包体格式
+using MessageHandler = std::function<void(
+    const std::shared_ptr<Connection> &conn, const Codec::Frame &frame)>;
+
+// 按 msg_type 查表分发。表在静态初始化阶段由各业务文件注册，
+// 服务启动后只读，分发时不加锁
+class MessageDispatcher {
+public:
+    static MessageDispatcher &GetInstance();
+    // 只能在服务启动前调用；同一个类型重复注册以后注册的为准
+    void Register(uint32_t msg_type, ExecMode mode, MessageHandler handler);
+    // 按注册的方式执行，未知类型返回 false
+    bool Dispatch(const std::shared_ptr<Connection> &conn,
+                  const Codec::Frame &frame) const;
+
+private:
+    struct Entry {
+        ExecMode mode = ExecMode::kInline;
+        MessageHandler handler;
+        Counter *frames = nullptr;  // 按类型的收包计数，注册时建好
+    };
+    MessageDispatcher() = default;
+    MessageDispatcher(const MessageDispatcher &) = delete;
+    MessageDispatcher &operator=(const MessageDispatcher &) = delete;
+    static void Invoke(const Entry &entry,
+                       const std::shared_ptr<Connection> &conn,
+                       const Codec::Frame &frame);
+
+    // 下标就是 msg_type，类型号都很小，直接数组查
+    std::vector<Entry> table_;
+    Counter *unknown_frames_ = nullptr;
+};
+
+// 业务文件里定义一个静态对象完成注册，新增命令不用改 Connection.cpp：
+//   static HandlerRegistrar reg(kMsgPing, ExecMode::kInline, HandlePing);
+struct HandlerRegistrar {
+    HandlerRegistrar(uint32_t msg_type, ExecMode mode,
+                     MessageHandler handler) {
+        MessageDispatcher::GetInstance().Register(msg_type, mode,
+                                                  std::move(handler));
+    }
+};
+#endif
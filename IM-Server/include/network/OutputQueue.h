@@ -0,0 +1,66 @@
+#ifndef OUTPUT_QUEUE_H
+#define OUTPUT_QUEUE_H
+#include <sys/types.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "common/BlockPool.h"
+
+// 打包好的一帧，发出去之前不再修改；可以被多个连接的发送队列共享
+using PacketPtr = std::shared_ptr<const std::string>;
+
+// 一次flush要分几次 sendmsg 写（超过 IOV_MAX 个包）时，怎么让内核别每次都单独发段
+enum class CorkMode {
+    kNone,     // 不做处理
+    kMsgMore,  // 除最后一次外都带 MSG_MORE
+    kTcpCork,  // 写之前打开 TCP_CORK，写完关掉（多两次 setsockopt）
+};
+// 配置里的 "none" / "msg_more" / "tcp_cork"，不认识的当 none
+CorkMode ParseCorkMode(const std::string &name);
+
+// 一次 WriteTo 的系统调用统计
+struct WriteStats {
+    size_t calls = 0;    // sendmsg 次数
+    size_t packets = 0;  // 完整写出的包数
+    // 写的过程中遇到的硬错误（EPIPE、ECONNRESET 等）的 errno，0 表示没有。
+    // 部分写之后才出错时返回值是正数，只能靠这里发现
+    int error = 0;
+};
+
+// 连接的发送队列：按顺序排队的不可变包，用一次 sendmsg 聚合写出多个包。
+// 部分写只推进队首包的偏移，保证字节不重发、不乱序。只在loop线程使用
+class OutputQueue {
+public:
+    // droppable：慢消费者策略允许丢掉的包（群聊推送）
+    void Push(PacketPtr packet, bool droppable = false);
+    bool Empty() const { return packets_.empty(); }
+    // 还没写出去的字节数
+    size_t PendingBytes() const { return pending_bytes_; }
+    size_t PendingPackets() const { return packets_.size(); }
+    void Clear();
+    // 从老到新丢掉可丢弃的包，直到待发字节不超过 target；
+    // 已经写出一部分的队首包不动。返回丢掉的字节数，packets 带回包数
+    size_t DropOldest(size_t target, size_t *packets);
+
+    // 尽量把队列写进fd，直到写空或内核缓冲区满。
+    // 返回本次写出的字节数；一个字节都没写出且出错时返回 -1，errno 有效。
+    // 硬错误另外记在 stats->error
+    ssize_t WriteTo(int fd, CorkMode mode = CorkMode::kNone,
+                    WriteStats *stats = nullptr);
+
+private:
+    // 丢掉已经写出的 n 个字节，返回其中完整写完的包数
+    size_t Consume(size_t n);
+
+    struct Entry {
+        PacketPtr packet;
+        bool droppable;
+    };
+    // deque 的索引表和分块都从 BlockPool 取，新连接不再各自 malloc
+    std::deque<Entry, PoolAllocator<Entry>> packets_;
+    size_t head_offset_ = 0;  // 队首包已经写出的字节
+    size_t pending_bytes_ = 0;
+};
+#endif
@@ -0,0 +1,43 @@
+#ifndef POLLER_H
+#define POLLER_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "network/Channel.h"
+
+// IO多路复用后端：EventLoop 只通过这个接口注册fd、等就绪事件。
+// 事件掩码统一用 EPOLLIN/EPOLLOUT/...（和 poll 的 POLLIN/POLLOUT 数值相同），
+// 默认是水平触发：没处理完的就绪事件下一轮还会再报；
+// Channel::Mode() 的边缘/单次触发只有支持的后端才认（见 SupportsMode）。只在所属loop线程使用
+class Poller {
+public:
+    struct Event {
+        Channel *channel;
+        uint32_t revents;
+    };
+    virtual ~Poller() = default;
+
+    // 等到有事件或超时（timeout_ms < 0 一直等），就绪的追加到 active。
+    // 返回追加的个数，出错返回 -1 并保留 errno
+    virtual int Poll(int timeout_ms, std::vector<Event> &active) = 0;
+    // 按Channel当前关注的事件注册/修改，维护 Channel::IsAdded
+    virtual void UpdateChannel(Channel *channel) = 0;
+    // 摘除后不会再收到新的就绪事件
+    virtual void RemoveChannel(Channel *channel) = 0;
+    virtual const char *Name() const = 0;
+    virtual bool SupportsMode(TriggerMode mode) const {
+        return mode == TriggerMode::kLevel;
+    }
+    // 改注册的次数（epoll_ctl 调用数，io_uring 是提交的注册/摘除请求数）
+    uint64_t CtlCalls() const { return ctl_calls_; }
+
+    // 按名字创建："epoll" / "io_uring"。io_uring 没编进来或者内核不支持时
+    // 打一条警告退回 epoll；epoll 都建不起来才抛异常
+    static std::unique_ptr<Poller> Create(const std::string &name);
+
+protected:
+    uint64_t ctl_calls_ = 0;
+};
+#endif
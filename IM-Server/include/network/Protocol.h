@@ -7,4 +7,13 @@ struct MsgHeader {
     uint32_t body_length;  // 消息体的长度
 };
 #pragma pack(pop)
+
+// 包头里的 msg_type
+enum MsgType : uint32_t {
+    kMsgLogin = 1,     // 登录
+    kMsgChat = 2,      // 单聊/群聊，以及服务端推送
+    kMsgPing = 3,      // 心跳
+    kMsgPong = 4,      // 心跳回包
+    kMsgPresence = 5,  // 查询一批用户是否在线
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef SOCKET_OPTIONS_H
+#define SOCKET_OPTIONS_H
+
+// 接入后对每个连接fd设置的选项，0 / false 表示不设置、用内核默认
+struct SocketOptions {
+    // 关掉 Nagle：小包不再等前一个包的 ACK，避免和延迟确认叠成几十毫秒的卡顿
+    bool no_delay = true;
+    // 收发缓冲区字节数；设置后内核不再自动调整这个方向的缓冲区
+    int send_buf = 0;
+    int recv_buf = 0;
+    // 收到数据立刻回 ACK。内核过一阵会自己退回延迟确认，
+    // 所以 Connection 每次读完都要重新设置一次
+    bool quick_ack = false;
+    // SO_BUSY_POLL：阻塞读之前在网卡队列上忙等的微秒数（需要网卡驱动支持）
+    int busy_poll_us = 0;
+    // TCP_USER_TIMEOUT：发出去的数据这么久没被确认就断开（毫秒）
+    int user_timeout_ms = 0;
+    // TCP 保活：空闲多少秒开始探测、探测间隔秒数、探测几次无响应算断开
+    bool keepalive = false;
+    int keepalive_idle = 60;
+    int keepalive_interval = 10;
+    int keepalive_count = 3;
+};
+
+// 逐项 setsockopt，全部成功返回 true。
+// 某一项失败只在第一次打警告（例如没有权限调大 SO_BUSY_POLL），其余照常设置
+bool ApplySocketOptions(int fd, const SocketOptions &options);
+// 重新打开快速确认，读完数据后调用
+void RearmQuickAck(int fd);
+#endif
@@ -0,0 +1,43 @@
+#ifndef STRAND_H
+#define STRAND_H
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "common/MpscQueue.h"
+#include "network/ThreadPool.h"
+
+// 串行执行器：投递到同一个 Strand 的任务严格按投递顺序、一个接一个执行，
+// 不同 Strand 之间照样并行。
+//   投递端无锁：入队 + 一次原子加；计数从 0 变 1 的那个投递者负责把
+//   Strand 挂到线程池上，其余的只排队。
+//   执行端在一个worker上连续跑完目标相同的任务，只有下一个任务要去
+//   另一个池时才换线程。
+class Strand : public std::enable_shared_from_this<Strand> {
+public:
+    using Task = std::function<void()>;
+    Strand() : pending_(0) {}
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+    // 任意线程调用，task 在 pool 上执行
+    void Post(ThreadPool &pool, Task task);
+
+private:
+    struct Item {
+        ThreadPool *pool = nullptr;
+        Task task;
+    };
+    // 一次最多连续执行这么多个，再排回池子里，避免一个连接霸占worker
+    static constexpr int kMaxBatch = 64;
+
+    void Schedule(ThreadPool *pool);
+    void Run(ThreadPool *pool);
+
+    MpscQueue<Item> queue_;
+    std::atomic<size_t> pending_;  // 已投递还没执行完的任务数
+    // 从队列里取出、但因为要换池还没执行的任务；只有当前执行者访问
+    Item front_;
+    bool has_front_ = false;
+};
+#endif
@@ -6,25 +6,96 @@
 #include <sys/types.h>
 #include <unistd.h>
 
-#include <map>
 #include <memory>  // 引入智能指针头文件
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "network/Acceptor.h"
+#include "network/AdminServer.h"
 #include "network/Connection.h"
 #include "network/EventLoop.h"
+#include "network/EventLoopThreadPool.h"
+#include "network/ListenerHandover.h"
+
+struct TcpServerOptions {
+    // 子reactor线程数，0 时退化为单reactor：accept与读写都在主loop
+    size_t io_threads = 0;
+    std::string balance_policy = "round_robin";
+    // listen 队列长度
+    int backlog = 128;
+    // >0 时开启 SO_REUSEPORT 分片：每个loop线程一个监听socket，自己accept自己处理
+    size_t reuseport_shards = 0;
+    // 分片模式下把第i个loop线程绑到第i个CPU，并挂BPF按CPU选socket，
+    // 让连接始终留在接它的那个核上
+    bool cpu_steering = false;
+    // 心跳超时秒数：这么久没收到任何包就断开，0 表示不检测
+    int idle_timeout = 30;
+    // 一次flush要分多次写时的合并方式：none / msg_more / tcp_cork
+    std::string cork_mode = "none";
+    // IO多路复用后端：epoll / io_uring（不可用时退回 epoll）
+    std::string poller = "epoll";
+    // 连接fd的注册方式：level / edge / oneshot（只有 epoll 支持后两种）
+    std::string trigger_mode = "level";
+    // 批量接入、fd 耗尽时的处理、接入限速和连接fd的socket选项
+    AcceptorOptions accept;
+    // 收发连接的loop的自适应忙轮询窗口（微秒），见 EventLoop::SetBusyPoll
+    int loop_spin_us = 0;
+    // 平滑重启：非空时启动先到这个 Unix socket 找旧进程领监听socket，
+    // 自己也在上面等下一个新进程。空表示不交接
+    std::string upgrade_path;
+    // 交出监听socket之后，这么多秒内分批关掉已有连接，然后退出
+    int drain_timeout = 30;
+    // 指标抓取端口（HTTP，Prometheus 文本格式），0 表示不开
+    std::string admin_ip = "127.0.0.1";
+    uint16_t admin_port = 0;
+};
 
 class TcpServer {
 public:
-    TcpServer(const std::string& ip, uint16_t port);
+    TcpServer(const std::string& ip, uint16_t port,
+              const TcpServerOptions& options = TcpServerOptions());
     ~TcpServer();
     // 启动服务器
     void start();
 
 private:
+    // 创建一个绑定好并开始监听的非阻塞socket
+    int CreateListenSocket(bool reuseport);
+    // 在accept所在线程调用：建Connection并交给io_loop
+    void NewConnection(int client_fd, EventLoop* io_loop);
+    // 在连接所属loop线程调用：从连接表摘除并在其loop上销毁
+    void RemoveConnection(int fd);
+    // 主loop上定时打一行内存池命中统计
+    void ReportPoolStats();
+    // 把各处已有的统计挂到指标注册表上，抓取时再读
+    void RegisterMetrics();
+    // 拿来的监听socket能不能用：正在监听本端口的 TCP socket
+    bool IsOurListenSocket(int fd) const;
+    // 新进程接手了监听socket：停止accept，开始排空连接
+    void BeginDrain();
+    // 每个tick关掉一批连接，剩下的时间里均匀关完，避免新进程一下子被重连打满
+    void DrainTick();
+
     std::string ip_;
     uint16_t port_;
-    int listen_fd_;  // 监听socket文件描述符
+    TcpServerOptions options_;
+    CorkMode cork_mode_;
+    TriggerMode trigger_mode_;
+    std::vector<int> listen_fds_;  // 监听socket文件描述符（分片模式下有多个）
+    // 排在loop之前声明，loop都析构之后才析构
+    std::vector<std::unique_ptr<Acceptor>> acceptors_;
+    std::unique_ptr<ListenerHandover> handover_;
+    std::unique_ptr<AdminServer> admin_;
+    int handover_peer_fd_ = -1;  // 从旧进程领到监听socket后，等开始accept再确认
     std::unique_ptr<EventLoop> loop_;
-    std::map<int, std::shared_ptr<Connection>> connections_;
+    std::unique_ptr<EventLoopThreadPool> thread_pool_;
+    // accept线程插入、各io线程删除，需要加锁。
+    // fd 是小而稠密的整数，直接按 fd 下标存，插入删除不再分配树节点
+    std::mutex conn_mutex_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+    TimerNode pool_stats_timer_;
+    TimerNode drain_timer_;
+    uint64_t drain_ticks_left_ = 0;
 };
-#endif
\ No newline at end of file
+#endif
@@ -1,72 +1,86 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
-#include <vector>
-#include <queue>
-#include <thread>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <spdlog/spdlog.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "common/MpscQueue.h"
+#include "common/WorkStealingDeque.h"
+
+class Histogram;
+
+// 工作窃取线程池：
+//   每个worker一个 Chase-Lev 双端队列，worker自己派生的任务压在自己队列底部；
+//   外部线程（IO loop）投递的任务进全局注入队列（无锁入队），
+//   空闲worker一次从注入队列取一批，其余的放进自己的队列给别人偷；
+//   找不到活先自旋一会儿，再在自己的 futex 字上睡，投递时有人睡着才唤醒。
 class ThreadPool {
 public:
-    static ThreadPool &GetInstance() {
-        static ThreadPool instance(4);
-        return instance;
-    }
-    void Enqueue(std::function<void()> task) {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            tasks_.push(std::move(task));
-        }
-        condition_.notify_one();
-    }
+    using Task = std::function<void()>;
+
+    // num_threads 为 0 时取 hardware_concurrency。
+    // name 非空时导出排队深度和排队等待时间（pool="name"），每个任务多取一次时钟
+    explicit ThreadPool(size_t num_threads, const std::string &name = "");
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // 跑会阻塞的任务（MySQL/Redis），线程数取配置 blocking_threads
+    static ThreadPool &GetInstance();
+    // 跑纯计算的任务，线程数取配置 cpu_threads；第一次用到时才创建
+    static ThreadPool &GetCpuInstance();
+
+    // 任意线程调用
+    void Enqueue(Task task);
+    size_t Size() const { return workers_.size(); }
+    // 排着还没开始执行的任务数，近似值
+    size_t QueueDepth() const;
 
 private:
-    ThreadPool(size_t num_threads) : stop_(false) {
-        for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this, i]() {
-                spdlog::info("Worker thread {} start.", i);
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex_);
-                        this->condition_.wait(lock, [this] {
-                            return this->stop_ || !this->tasks_.empty();
-                        });
-                        if (this->stop_ && this->tasks_.empty()) {
-                            spdlog::info("Worker thread {} exiting.", i);
-                            return;
-                        }
+    struct Item {
+        Task fn;
+        uint64_t enqueue_us = 0;  // 开了统计才记
+    };
+    struct Worker {
+        WorkStealingDeque<Item *> deque;
+        std::thread thread;
+        uint64_t rng = 0;  // 选偷取对象用的 xorshift 状态
+        // futex 字：1 表示睡着且还没人叫，唤醒方负责把它改回 0
+        std::atomic<uint32_t> parked{0};
+    };
+    // 空闲时先自旋这么多轮再睡
+    static constexpr int kSpinRounds = 64;
+    // 自旋之后再让出几次CPU，给生产者攒一批的机会，最后才 futex 睡眠
+    static constexpr int kYieldRounds = 8;
+    // 从注入队列一次最多搬走的任务数
+    static constexpr size_t kInjectBatch = 32;
 
-                        task = std::move(this->tasks_.front());
-                        this->tasks_.pop();
-                    }
-                    if (task) {
-                        task();
-                    }
-                }
-            });
-        }
-    }
+    void WorkerLoop(size_t index);
+    // 按 本地队列 -> 注入队列 -> 偷别人 的顺序找活
+    Item *FindTask(Worker &self, size_t index);
+    Item *TakeInjected(Worker &self);
+    Item *StealFromOthers(Worker &self, size_t index);
+    bool HasWork() const;
+    void Park(Worker &self);
+    // 叫醒一个睡着的worker，每个睡眠者只会被叫一次，没人睡就不做系统调用
+    void NotifyOne();
+    void NotifyAll();
 
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
-        }
-        condition_.notify_all();
-        for (std::thread &worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-    }
-    std::vector<std::thread> workers_;         // 打工队列
-    std::queue<std::function<void()>> tasks_;  // 共享任务队列
-    std::mutex queue_mutex_;                   // 锁
-    std::condition_variable condition_;        // 条件变量
-    bool stop_;                                // 停止标志
+    std::vector<std::unique_ptr<Worker>> workers_;
+    // 单核机器上自旋只会挡住真正干活的线程，直接睡
+    int spin_rounds_;
+    // 全局注入队列：生产者无锁入队，消费者同一时刻只允许一个worker在取
+    MpscQueue<Item *> inject_queue_;
+    std::atomic<bool> inject_busy_;
+    std::atomic<size_t> inject_size_;
+    // 已经睡下、还没被叫醒的worker数
+    std::atomic<int> sleepers_;
+    std::atomic<bool> stop_;
+    std::string name_;
+    Histogram *wait_histogram_ = nullptr;  // 没有名字的池不统计
 };
-#endif
\ No newline at end of file
+#endif
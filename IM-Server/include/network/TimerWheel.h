@@ -0,0 +1,55 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+#include <cstdint>
+#include <functional>
+
+// 侵入式双向链表节点，轮上的每个槽是一个哨兵
+struct TimerListHead {
+    TimerListHead *prev = nullptr;
+    TimerListHead *next = nullptr;
+};
+
+// 定时器节点嵌在使用者对象里（例如Connection），加入/刷新/删除都不分配内存
+struct TimerNode : TimerListHead {
+    uint64_t expire = 0;  // 到期的tick
+    std::function<void()> callback;
+    bool IsLinked() const { return next != nullptr; }
+};
+
+// 分层时间轮（类似 Linux 经典 timer wheel）：
+// 第0层 256 个槽，每槽 1 tick；往上每层 64 个槽，每槽跨度是下一层的整圈。
+// 插入、刷新、删除 O(1)；高层的槽转到时整槽下放（cascade），均摊 O(1)。
+// 只在所属loop线程使用
+class TimerWheel {
+public:
+    TimerWheel();
+    ~TimerWheel();
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    // delay_ticks 个tick之后到期；节点已在轮上则先摘下
+    void Add(TimerNode *node, uint64_t delay_ticks);
+    void Remove(TimerNode *node);
+    // 把到期时间推到 now+delay；和原来是同一个tick就什么都不做
+    void Refresh(TimerNode *node, uint64_t delay_ticks);
+    // 时间前进 ticks 个tick，执行到期节点的回调（回调前节点已被摘下）
+    void Advance(uint64_t ticks);
+    uint64_t CurrentTick() const { return current_; }
+
+private:
+    static const int kRootBits = 8;
+    static const int kLevelBits = 6;
+    static const int kRootSize = 1 << kRootBits;
+    static const int kLevelSize = 1 << kLevelBits;
+    static const int kLevels = 4;  // 1 个根层 + 3 个上层，覆盖 2^26 tick
+
+    void Link(TimerNode *node);
+    // 把第 level 层 index 槽的节点按新的剩余时间重新挂到下层
+    void Cascade(int level, int index);
+    void RunSlot(TimerListHead *slot);
+
+    uint64_t current_;
+    TimerListHead root_[kRootSize];
+    TimerListHead levels_[kLevels - 1][kLevelSize];
+};
+#endif
@@ -7,6 +7,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+// 一条离线消息，推送时再按接收方的包体格式编码
+struct OfflineMessage {
+    std::string sender;
+    std::string content;
+    std::string send_time;
+};
 class MySQLManager {
 public:
     static MySQLManager &GetInstance();
@@ -25,7 +31,7 @@ public:
                               const std::string &content);
 
     // 提取并清理离线消息 (去掉 &，按值返回，依赖 C++ RVO 优化机制)
-    std::vector<std::string> GetAndClearOfflineMessages(
+    std::vector<OfflineMessage> GetAndClearOfflineMessages(
         const std::string &receiver);
     // 查询群所有成员
     std::unordered_map<int, std::unordered_set<std::string>>
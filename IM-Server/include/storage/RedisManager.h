@@ -3,14 +3,22 @@
 #include <string>
 #include <memory>
 #include <chrono>
-#include <spdlog/spdlog.h>
 #include <sw/redis++/redis++.h>
 
+#include "common/Logging.h"
+#include "common/Metrics.h"
+
 class RedisManager {
 private:
     RedisManager() = default;
     ~RedisManager() = default;
     std::unique_ptr<sw::redis::Redis> redis_;
+    // 每种调用一个延迟直方图
+    static Histogram* CallLatency(const char* op) {
+        return MetricsRegistry::GetInstance().GetHistogram(
+            "im_redis_call_seconds", "Redis call latency",
+            std::string("op=\"") + op + "\"", 1e-6);
+    }
 
 public:
     static RedisManager& GetInstance() {
@@ -29,49 +37,55 @@ public:
 
             // 发送ping 测试连通
             if (redis_->ping() == "PONG") {
-                spdlog::info("Successfully connected to Redis at {}:{}", host,
-                             port);
+                IM_INFO("Successfully connected to Redis at %s:%d",
+                        host.c_str(), port);
                 return true;
             }
             return false;
         } catch (const sw::redis::Error& e) {
-            spdlog::error("Redis Init failed: {}", e.what());
+            IM_ERROR("Redis Init failed: %s", e.what());
             return false;
         }
     }
     // 1、用户上线（代表120s过期时间，防止服务器崩溃导致幽灵在）
     bool SetUserOnline(const std::string& username) {
         if (!redis_) return false;
+        static Histogram* latency = CallLatency("set_online");
+        ScopedLatency timer(latency);
         try {
             std::string key = "online:user:" + username;
             redis_->set(key, "1", std::chrono::seconds(120));
             return true;
         } catch (const sw::redis::Error& e) {
-            spdlog::error("Redis SetUserOnline error:{}", e.what());
+            IM_ERROR("Redis SetUserOnline error:%s", e.what());
             return false;
         }
     }
     // 2、用户下线
     bool SetUserOffline(const std::string& username) {
         if (!redis_) return false;
+        static Histogram* latency = CallLatency("set_offline");
+        ScopedLatency timer(latency);
         try {
             std::string key = "online:user:" + username;
             redis_->del(key);
             return true;
         } catch (const sw::redis::Error& e) {
-            spdlog::error("Redis SetUserOffline error:{}", e.what());
+            IM_ERROR("Redis SetUserOffline error:%s", e.what());
             return false;
         }
     }
     // 3、查询是否在线
     bool IsUserOnlinea(const std::string& username) {
         if (!redis_) return false;
+        static Histogram* latency = CallLatency("is_online");
+        ScopedLatency timer(latency);
         try {
             std::string key = "online:user:" + username;
             auto val = redis_->get(key);
             return val.has_value();
         } catch (const sw::redis::Error& e) {
-            spdlog::error("Redis IsUserOnline error: {}", e.what());
+            IM_ERROR("Redis IsUserOnline error: %s", e.what());
             return false;
         }
     }
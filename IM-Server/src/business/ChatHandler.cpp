@@ -0,0 +1,136 @@
+#include <string>
+#include <vector>
+
+#include "business/GroupManager.h"
+#include "business/UserManager.h"
+#include "common/Logging.h"
+#include "network/BodyCodec.h"
+#include "network/Connection.h"
+#include "network/MessageDispatcher.h"
+#include "storage/MySQLManager.h"
+
+// 单聊：目标在线直接推，不在线落库
+static void HandlePrivateChat(const std::shared_ptr<Connection> &conn,
+                              const BodyReader &req, BodyWriter &resp) {
+    const std::string &from = conn->GetUser();
+    std::string target_user(req.GetString(Field::kTo));
+    std::string_view content = req.GetString(Field::kMsg);
+    IM_DEBUG("Route msg from '%s' to '%s'", from.c_str(),
+             target_user.c_str());
+    auto target_conn_ptr =
+        UserManager::GetInstance().GetConnection(target_user).lock();
+    if (target_conn_ptr != nullptr) {  // 目标在线
+        // 按接收方协商的格式编码
+        BodyWriter push(target_conn_ptr->PushFormat());
+        push.SetCmd(Cmd::kPushChat)
+            .SetString(Field::kFrom, from)
+            .SetString(Field::kMsg, content);
+        // 跨对象调用
+        target_conn_ptr->Send(
+            push.Pack(kMsgChat, target_conn_ptr->CompressPush()));
+        resp.SetInt(Field::kCode, 200);
+        resp.SetString(Field::kMsg, "Message forwarded successfully.");
+        return;
+    }
+    // 目标不在线
+    IM_INFO("User '%s' if offline. Saving message to database",
+            target_user.c_str());
+    bool saved = MySQLManager::GetInstance().InsertOfflineMessage(
+        from, target_user, std::string(content));
+    if (saved) {  // 用户离线，存放数据库
+        resp.SetInt(Field::kCode, 200);
+        resp.SetString(Field::kMsg,
+                       "User offline. Message save to server successfully.");
+    } else {  // 数据库挂了
+        resp.SetInt(Field::kCode, 500);
+        resp.SetString(Field::kMsg,
+                       "Internal server erro.Failed to save message");
+    }
+}
+
+// 群聊：推送内容对同一种编码的所有人都一样，每种编码只打包一次，
+// 按loop批量投递
+static void HandleGroupChat(const std::shared_ptr<Connection> &conn,
+                            const BodyReader &req, BodyWriter &resp) {
+    const std::string &from = conn->GetUser();
+    int group_id = static_cast<int>(req.GetInt(Field::kGroupId, -1));
+    std::string_view content = req.GetString(Field::kMsg);
+    // 1、验证：发送者自己必须在群里
+    if (!GroupManager::GetInstance().IsUserInGroup(group_id, from)) {
+        resp.SetInt(Field::kCode, 403);
+        resp.SetString(Field::kMsg,
+                       "Permission denied.You are not in the group");
+        return;
+    }
+    // 2、拿到群名单
+    auto members = GroupManager::GetInstance().GetGroupMembers(group_id);
+    // 3. 核心路由分支：一次加锁查完整个名单
+    std::vector<std::shared_ptr<Connection>> online;
+    std::vector<std::string> offline;
+    UserManager::GetInstance().GetConnections(*members, from, online,
+                                              offline);
+    // 按 (格式, 是否压缩) 分成4组：下标 bit0 是二进制，bit1 是压缩
+    std::vector<std::shared_ptr<Connection>> groups[4];
+    for (auto &member : online) {
+        int index = (member->PushFormat() == BodyFormat::kBinary ? 1 : 0) |
+                    (member->CompressPush() ? 2 : 0);
+        groups[index].push_back(std::move(member));
+    }
+    size_t online_count = 0;
+    for (int index = 0; index < 4; ++index) {
+        if (groups[index].empty()) continue;
+        online_count += groups[index].size();
+        BodyWriter push((index & 1) ? BodyFormat::kBinary : BodyFormat::kJson);
+        push.SetCmd(Cmd::kPushGroupChat)
+            .SetInt(Field::kGroupId, group_id)
+            .SetString(Field::kFrom, from)
+            .SetString(Field::kMsg, content);
+        // 同一个共享帧按所属loop批量投递
+        Connection::Broadcast(groups[index],
+                              std::make_shared<const std::string>(
+                                  push.Pack(kMsgChat, (index & 2) != 0)));
+    }
+    std::string offline_content = "[群聊] " + std::string(content);
+    for (const auto &member : offline) {
+        MySQLManager::GetInstance().InsertOfflineMessage(from, member,
+                                                         offline_content);
+    }
+    // 4. 给发送者回执
+    resp.SetInt(Field::kCode, 200);
+    resp.SetString(Field::kMsg,
+                   "Group message sent! Online: " +
+                       std::to_string(online_count) + ", Offline saved: " +
+                       std::to_string(offline.size()));
+}
+
+static void HandleChat(const std::shared_ptr<Connection> &conn,
+                       const Codec::Frame &frame) {
+    BodyReader req;
+    if (!req.Parse(frame.Format(), frame.body)) {
+        IM_WARN("Bad chat body on fd %d", conn->GetFd());
+        return;
+    }
+    BodyWriter resp(frame.Format());
+    if (!req.TextValid()) {
+        resp.SetInt(Field::kCode, 400);
+        resp.SetString(Field::kMsg, "Text fields must be valid UTF-8");
+        conn->Send(resp.Pack(frame.msg_type, conn->CompressPush()));
+        return;
+    }
+    switch (req.GetCmd()) {
+        case Cmd::kChat:
+            HandlePrivateChat(conn, req, resp);
+            break;
+        case Cmd::kGroupChat:
+            HandleGroupChat(conn, req, resp);
+            break;
+        default:
+            break;
+    }
+    // 给发送者回执包
+    conn->Send(resp.Pack(frame.msg_type, conn->CompressPush()));
+}
+
+// 离线消息要落库，放阻塞池
+static HandlerRegistrar chat_registrar(kMsgChat, ExecMode::kBlocking,
+                                       HandleChat);
@@ -1,27 +1,34 @@
 #include "business/GroupManager.h"
 
-#include <spdlog/spdlog.h>
-
+#include "common/Logging.h"
 #include "storage/MySQLManager.h"
 void GroupManager::InitLoadFromDB() {
+    auto groups = MySQLManager::GetInstance().GetAllGroupMembers();
     std::lock_guard<std::mutex> lock(mutex_);
-    group_map_ = MySQLManager::GetInstance().GetAllGroupMembers();
-    spdlog::info("GroupManager initialized.Load {} group from DB.",
-                 group_map_.size());
+    group_map_.clear();
+    for (auto &group : groups) {
+        group_map_[group.first] =
+            std::make_shared<const MemberSet>(std::move(group.second));
+    }
+    IM_INFO("GroupManager initialized.Load %zu group from DB.",
+            group_map_.size());
 }
 
-std::unordered_set<std::string> GroupManager::GetGroupMembers(int group_id) {
+std::shared_ptr<const std::unordered_set<std::string>>
+GroupManager::GetGroupMembers(int group_id) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (group_map_.find(group_id) == group_map_.end()) {
-        return {};
+    auto it = group_map_.find(group_id);
+    if (it == group_map_.end()) {
+        return std::make_shared<const MemberSet>();
     }
-    return group_map_[group_id];
+    return it->second;
 }
 
 bool GroupManager::IsUserInGroup(int group_id, const std::string &username) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (group_map_.find(group_id) == group_map_.end()) {
+    auto it = group_map_.find(group_id);
+    if (it == group_map_.end()) {
         return false;
     }
-    return group_map_[group_id].count(username) > 0;
-}
\ No newline at end of file
+    return it->second->count(username) > 0;
+}
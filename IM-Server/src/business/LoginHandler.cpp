@@ -0,0 +1,77 @@
+#include <string>
+
+#include "business/UserManager.h"
+#include "common/Logging.h"
+#include "network/BodyCodec.h"
+#include "network/Compressor.h"
+#include "network/Connection.h"
+#include "network/MessageDispatcher.h"
+#include "storage/MySQLManager.h"
+#include "storage/RedisManager.h"
+
+// 登录：查库、写Redis、拉离线消息，全是阻塞调用。
+// 用二进制登录、或者JSON登录里带 "binary": true，之后的推送都用二进制
+static void HandleLogin(const std::shared_ptr<Connection> &conn,
+                        const Codec::Frame &frame) {
+    BodyReader req;
+    if (!req.Parse(frame.Format(), frame.body)) {
+        IM_WARN("Bad login body on fd %d", conn->GetFd());
+        return;
+    }
+    if (req.GetCmd() != Cmd::kLogin) return;
+    BodyWriter resp(frame.Format());
+    resp.SetCmd(Cmd::kLoginResp);
+    // 用户名会出现在发给别人的推送里
+    if (!req.TextValid()) {
+        resp.SetInt(Field::kCode, 400);
+        resp.SetString(Field::kMsg, "Text fields must be valid UTF-8");
+        conn->Send(resp.Pack(frame.msg_type));
+        return;
+    }
+    std::string username(req.GetString(Field::kUsername));
+    std::string password(req.GetString(Field::kPassword));
+
+    bool is_valid = MySQLManager::GetInstance().CheckUser(username, password);
+    if (!is_valid) {
+        resp.SetInt(Field::kCode, 401);
+        resp.SetString(Field::kMsg, "Invalid username or password");
+        conn->Send(resp.Pack(frame.msg_type));
+        return;
+    }
+    resp.SetInt(Field::kCode, 200);
+    resp.SetString(Field::kMsg, "Login Success!");
+    bool binary = frame.Format() == BodyFormat::kBinary ||
+                  req.GetBool(Field::kBinary);
+    conn->SetPushFormat(binary ? BodyFormat::kBinary : BodyFormat::kJson);
+    // 客户端声明能解压、服务端也编了压缩才打开，回包里告诉客户端结果
+    bool compress = req.GetBool(Field::kCompress) &&
+                    Compressor::GetInstance().Available();
+    conn->SetCompressPush(compress);
+    if (compress) resp.SetInt(Field::kCompress, 1);
+    conn->SetUser(username);
+    UserManager::GetInstance().AddUser(username, conn);
+    IM_INFO("User '%s' login and registered in UserManager.",
+            username.c_str());
+    // 将状态写入redis
+    RedisManager::GetInstance().SetUserOnline(username);
+    IM_INFO("User '%s' status synced to Redis (Online).", username.c_str());
+    conn->Send(resp.Pack(frame.msg_type, compress));
+    // 获取离线消息
+    auto offline_msgs =
+        MySQLManager::GetInstance().GetAndClearOfflineMessages(username);
+    if (!offline_msgs.empty()) {
+        IM_INFO("pushing %zu offline message to user '%s'",
+                offline_msgs.size(), username.c_str());
+        for (const auto &msg : offline_msgs) {
+            BodyWriter push(conn->PushFormat());
+            push.SetCmd(Cmd::kPushChat)
+                .SetString(Field::kFrom, msg.sender)
+                .SetString(Field::kMsg, msg.content)
+                .SetString(Field::kTime, msg.send_time);
+            conn->Send(push.Pack(kMsgChat, compress));
+        }
+    }
+}
+
+static HandlerRegistrar login_registrar(kMsgLogin, ExecMode::kBlocking,
+                                        HandleLogin);
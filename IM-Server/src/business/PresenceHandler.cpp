@@ -0,0 +1,69 @@
+#include <memory>
+#include <string>
+
+#include "business/UserManager.h"
+#include "common/Logging.h"
+#include "network/BodyCodec.h"
+#include "network/Connection.h"
+#include "network/MessageDispatcher.h"
+
+// 一次在线查询最多带多少个用户，保证在IO线程上的开销有上限
+static const size_t kMaxPresenceQuery = 256;
+
+// 心跳：直接在IO线程回 pong，不看包体
+static void HandlePing(const std::shared_ptr<Connection> &conn,
+                       const Codec::Frame &frame) {
+    IM_TRACE("Received Ping from fd %d", conn->GetFd());
+    // 所有连接共用同一份 pong 包，每次心跳只加引用计数，不拷贝不分配
+    static const PacketPtr pong_json = std::make_shared<const std::string>(
+        Codec::PackMessage(kMsgPong, "{\"msg\":\"pong\"}"));
+    // 二进制客户端回空包体
+    static const PacketPtr pong_binary = std::make_shared<const std::string>(
+        Codec::PackMessage(kMsgPong | Codec::kBinaryBody, ""));
+    conn->Send(frame.Format() == BodyFormat::kBinary ? pong_binary
+                                                     : pong_json);
+}
+
+// 在线查询：{"cmd":"presence","users":["a","b"]}
+// 只查内存里的在线表，不碰数据库，同样在IO线程直接回
+static void HandlePresence(const std::shared_ptr<Connection> &conn,
+                           const Codec::Frame &frame) {
+    BodyReader req;
+    if (!req.Parse(frame.Format(), frame.body)) {
+        IM_WARN("Bad presence body on fd %d", conn->GetFd());
+        return;
+    }
+    BodyWriter resp(frame.Format());
+    resp.SetCmd(Cmd::kPresenceResp);
+    std::vector<std::string_view> users;
+    if (!req.TextValid()) {
+        resp.SetInt(Field::kCode, 400);
+        resp.SetString(Field::kMsg, "Text fields must be valid UTF-8");
+        conn->Send(resp.Pack(frame.msg_type, conn->CompressPush()));
+        return;
+    }
+    if (!req.GetStrings(Field::kUsers, users) ||
+        users.size() > kMaxPresenceQuery) {
+        resp.SetInt(Field::kCode, 400);
+        resp.SetString(Field::kMsg, "users must be an array of at most " +
+                                        std::to_string(kMaxPresenceQuery) +
+                                        " names");
+        conn->Send(resp.Pack(frame.msg_type, conn->CompressPush()));
+        return;
+    }
+    // 整批只加一次锁，少和工作线程上的登录/下线抢 UserManager 的锁
+    std::vector<std::string> names(users.begin(), users.end());
+    std::vector<bool> online;
+    UserManager::GetInstance().GetPresence(names, online);
+    resp.SetInt(Field::kCode, 200);
+    resp.SetEmptyMap(Field::kStatus);
+    for (size_t i = 0; i < names.size(); ++i) {
+        resp.AddStatus(Field::kStatus, names[i], online[i]);
+    }
+    conn->Send(resp.Pack(frame.msg_type, conn->CompressPush()));
+}
+
+static HandlerRegistrar ping_registrar(kMsgPing, ExecMode::kInline,
+                                       HandlePing);
+static HandlerRegistrar presence_registrar(kMsgPresence, ExecMode::kInline,
+                                           HandlePresence);
@@ -26,22 +26,32 @@ std::weak_ptr<Connection> UserManager::GetConnection(
     return std::weak_ptr<Connection>();
 }
 
-void UserManager::CheckTimeouts(int timeout_seconds) {
+void UserManager::GetConnections(
+    const std::unordered_set<std::string>& usernames,
+    const std::string& exclude,
+    std::vector<std::shared_ptr<Connection>>& online,
+    std::vector<std::string>& offline) {
+    online.reserve(usernames.size());
     std::lock_guard<std::mutex> lock(mutex_);
-    time_t now = time(NULL);
-
-    for (auto it = user_map_.begin(); it != user_map_.end();) {
-        if (auto conn = it->second.lock()) {
-            if (now - conn->GetLastActiveTime() > timeout_seconds) {
-                spdlog::warn("User '{}' timeout, kicking out.", it->first);
-                // 1、强制断开socket
-                // 2、从用户本移除
-                it = user_map_.erase(it);
-            } else {
-                ++it;
-            }
+    for (const auto& username : usernames) {
+        if (username == exclude) continue;
+        auto it = user_map_.find(username);
+        std::shared_ptr<Connection> conn;
+        if (it != user_map_.end()) conn = it->second.lock();
+        if (conn) {
+            online.push_back(std::move(conn));
         } else {
-            it = user_map_.erase(it);
+            offline.push_back(username);
         }
     }
-}
\ No newline at end of file
+}
+
+void UserManager::GetPresence(const std::vector<std::string>& usernames,
+                              std::vector<bool>& online) {
+    online.assign(usernames.size(), false);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < usernames.size(); ++i) {
+        auto it = user_map_.find(usernames[i]);
+        online[i] = it != user_map_.end() && !it->second.expired();
+    }
+}
@@ -0,0 +1,155 @@
+#include "common/BlockPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// 64B, 128B, ... 64KB 共 11 级
+static const size_t kNumClasses = 11;
+// 每个线程每级最多缓存的字节数（至少 kMinLocal 块）
+static const size_t kLocalBytes = 256 * 1024;
+static const size_t kMinLocal = 4;
+// 全局仓库每级最多闲置的字节数，再多就还给系统
+static const size_t kDepotBytes = 16 * 1024 * 1024;
+// 线程缓存空了一次从仓库取多少块
+static const size_t kRefillBatch = 32;
+// 命中数先在线程里攒着，攒够这么多再加到全局计数上，免得每次分配都抢一条缓存行
+static const uint64_t kHitFlush = 256;
+
+static size_t ClassIndex(size_t size) {
+    size_t index = 0;
+    size_t block = BlockPool::kMinBlock;
+    while (block < size) {
+        block <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+static size_t ClassSize(size_t index) { return BlockPool::kMinBlock << index; }
+
+static size_t LocalLimit(size_t index) {
+    size_t count = kLocalBytes / ClassSize(index);
+    return count < kMinLocal ? kMinLocal : count;
+}
+
+namespace {
+struct Depot {
+    std::mutex mutex[kNumClasses];
+    std::vector<void *> blocks[kNumClasses];
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> refills{0};
+    std::atomic<uint64_t> oversize{0};
+    std::atomic<uint64_t> cached_bytes{0};
+
+    // 把 blocks 里多出来的块放进仓库，仓库满了就直接释放
+    void Put(size_t index, std::vector<void *> &from, size_t keep) {
+        size_t limit = kDepotBytes / ClassSize(index);
+        std::lock_guard<std::mutex> lock(mutex[index]);
+        while (from.size() > keep) {
+            void *block = from.back();
+            from.pop_back();
+            if (blocks[index].size() < limit) {
+                blocks[index].push_back(block);
+                cached_bytes.fetch_add(ClassSize(index),
+                                       std::memory_order_relaxed);
+            } else {
+                ::operator delete(block);
+            }
+        }
+    }
+    // 最多取 kRefillBatch 块放进 to
+    void Take(size_t index, std::vector<void *> &to) {
+        std::lock_guard<std::mutex> lock(mutex[index]);
+        std::vector<void *> &list = blocks[index];
+        size_t n = list.size() < kRefillBatch ? list.size() : kRefillBatch;
+        to.insert(to.end(), list.end() - n, list.end());
+        list.resize(list.size() - n);
+        cached_bytes.fetch_sub(n * ClassSize(index),
+                               std::memory_order_relaxed);
+    }
+};
+
+// 进程退出前不析构：别的线程的缓存析构时还要往这里还
+Depot &GetDepot() {
+    static Depot *depot = new Depot();
+    return *depot;
+}
+
+// 线程退出时别的 thread_local 析构还可能来释放块，那时缓存已经没了
+thread_local bool local_cache_gone = false;
+
+struct LocalCache {
+    std::vector<void *> blocks[kNumClasses];
+    uint64_t hits = 0;
+    ~LocalCache() {
+        GetDepot().hits.fetch_add(hits, std::memory_order_relaxed);
+        // 线程退出，缓存整个还给仓库
+        for (size_t i = 0; i < kNumClasses; ++i) {
+            GetDepot().Put(i, blocks[i], 0);
+        }
+        local_cache_gone = true;
+    }
+};
+
+thread_local LocalCache local_cache;
+}  // namespace
+
+void *BlockPool::Allocate(size_t size) {
+    Depot &depot = GetDepot();
+    if (size > kMaxBlock) {
+        depot.oversize.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    size_t index = ClassIndex(size);
+    if (local_cache_gone) {
+        depot.misses.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(ClassSize(index));
+    }
+    std::vector<void *> &blocks = local_cache.blocks[index];
+    if (blocks.empty()) {
+        depot.Take(index, blocks);
+        if (blocks.empty()) {
+            depot.misses.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(ClassSize(index));
+        }
+        depot.refills.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (++local_cache.hits == kHitFlush) {
+        depot.hits.fetch_add(kHitFlush, std::memory_order_relaxed);
+        local_cache.hits = 0;
+    }
+    void *block = blocks.back();
+    blocks.pop_back();
+    return block;
+}
+
+void BlockPool::Deallocate(void *ptr, size_t size) {
+    if (ptr == nullptr) return;
+    if (size > kMaxBlock || local_cache_gone) {
+        ::operator delete(ptr);
+        return;
+    }
+    size_t index = ClassIndex(size);
+    std::vector<void *> &blocks = local_cache.blocks[index];
+    blocks.push_back(ptr);
+    // 只释放不分配的线程（比如工作线程析构连接）别把块都囤在自己这里
+    size_t limit = LocalLimit(index);
+    if (blocks.size() > limit) GetDepot().Put(index, blocks, limit / 2);
+}
+
+size_t BlockPool::BlockSize(size_t size) {
+    return size > kMaxBlock ? size : ClassSize(ClassIndex(size));
+}
+
+BlockPool::Stats BlockPool::GetStats() {
+    Depot &depot = GetDepot();
+    Stats stats;
+    stats.hits = depot.hits.load(std::memory_order_relaxed);
+    stats.misses = depot.misses.load(std::memory_order_relaxed);
+    stats.refills = depot.refills.load(std::memory_order_relaxed);
+    stats.oversize = depot.oversize.load(std::memory_order_relaxed);
+    stats.cached_bytes = depot.cached_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
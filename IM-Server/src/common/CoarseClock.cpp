@@ -0,0 +1,3 @@
+#include "common/CoarseClock.h"
+
+std::atomic<time_t> CoarseClock::now_{time(NULL)};
@@ -27,6 +27,102 @@ bool Config::Load(const std::string &config_file)
         // 解析并赋值
         server_ip_ = config_json["server"]["ip"];
         server_port_ = config_json["server"]["port"];
+        // 可选项，缺省保持单reactor
+        io_threads_ = config_json["server"].value("io_threads", 0);
+        balance_policy_ =
+            config_json["server"].value("balance_policy", "round_robin");
+        backlog_ = config_json["server"].value("backlog", 128);
+        reuseport_shards_ = config_json["server"].value("reuseport_shards", 0);
+        cpu_steering_ = config_json["server"].value("cpu_steering", false);
+        heartbeat_timeout_ =
+            config_json["server"].value("heartbeat_timeout", 30);
+        cork_mode_ = config_json["server"].value("cork_mode", "none");
+        poller_ = config_json["server"].value("poller", "epoll");
+        trigger_mode_ = config_json["server"].value("trigger_mode", "level");
+        blocking_threads_ =
+            config_json["server"].value("blocking_threads", 4);
+        cpu_threads_ = config_json["server"].value("cpu_threads", 0);
+        // 日志段可以整个省略
+        if (config_json.contains("log"))
+        {
+            const json &log = config_json["log"];
+            log_dir_ = log.value("dir", ".");
+            log_base_ = log.value("base", "app");
+            log_level_ = log.value("level", "info");
+            log_trace_ = log.value("trace", false);
+        }
+        if (config_json.contains("compression"))
+        {
+            const json &compression = config_json["compression"];
+            compress_enable_ = compression.value("enable", true);
+            compress_threshold_ = compression.value("threshold", 512);
+            compress_acceleration_ = compression.value("acceleration", 1);
+            compress_stats_interval_ =
+                compression.value("stats_interval", 60);
+        }
+        if (config_json.contains("flow_control"))
+        {
+            const json &flow = config_json["flow_control"];
+            flow_high_water_ = flow.value("high_water", flow_high_water_);
+            flow_low_water_ = flow.value("low_water", flow_low_water_);
+            flow_hard_limit_ = flow.value("hard_limit", flow_hard_limit_);
+            flow_global_budget_ =
+                flow.value("global_budget", flow_global_budget_);
+            flow_policy_ = flow.value("policy", "drop_oldest");
+        }
+        if (config_json.contains("acceptor"))
+        {
+            const json &acceptor = config_json["acceptor"];
+            accept_batch_ = acceptor.value("batch", accept_batch_);
+            accept_rate_ = acceptor.value("rate", accept_rate_);
+            accept_burst_ = acceptor.value("burst", accept_burst_);
+        }
+        if (config_json.contains("socket"))
+        {
+            const json &socket = config_json["socket"];
+            socket_preset_ = socket.value("preset", "default");
+            // 预设只改缺省值，段里显式写了的项以显式值为准
+            if (socket_preset_ == "low_latency")
+            {
+                socket_quick_ack_ = true;
+                socket_busy_poll_us_ = 50;
+                loop_spin_us_ = 100;
+            }
+            else if (socket_preset_ != "default")
+            {
+                std::cerr << "Unknown socket preset: " << socket_preset_
+                          << ", use default" << std::endl;
+                socket_preset_ = "default";
+            }
+            socket_no_delay_ = socket.value("no_delay", socket_no_delay_);
+            socket_send_buf_ = socket.value("send_buf", socket_send_buf_);
+            socket_recv_buf_ = socket.value("recv_buf", socket_recv_buf_);
+            socket_quick_ack_ = socket.value("quick_ack", socket_quick_ack_);
+            socket_busy_poll_us_ =
+                socket.value("busy_poll_us", socket_busy_poll_us_);
+            socket_user_timeout_ms_ =
+                socket.value("user_timeout_ms", socket_user_timeout_ms_);
+            socket_keepalive_ = socket.value("keepalive", socket_keepalive_);
+            socket_keepalive_idle_ =
+                socket.value("keepalive_idle", socket_keepalive_idle_);
+            socket_keepalive_interval_ =
+                socket.value("keepalive_interval", socket_keepalive_interval_);
+            socket_keepalive_count_ =
+                socket.value("keepalive_count", socket_keepalive_count_);
+            loop_spin_us_ = socket.value("loop_spin_us", loop_spin_us_);
+        }
+        if (config_json.contains("upgrade"))
+        {
+            const json &upgrade = config_json["upgrade"];
+            upgrade_path_ = upgrade.value("socket_path", "");
+            drain_timeout_ = upgrade.value("drain_timeout", drain_timeout_);
+        }
+        if (config_json.contains("admin"))
+        {
+            const json &admin = config_json["admin"];
+            admin_ip_ = admin.value("ip", admin_ip_);
+            admin_port_ = admin.value("port", admin_port_);
+        }
         // 【新增】解析数据库配置
         db_host_ = config_json["mysql"]["host"];
         db_port_ = config_json["mysql"]["port"];
@@ -0,0 +1,25 @@
+#include "common/Logging.h"
+
+std::atomic<bool> ServerLog::trace_enabled_{false};
+
+static LogLevel ParseLevel(const std::string &level) {
+    if (level == "debug") return LogLevel::DEBUG;
+    if (level == "warn") return LogLevel::WARN;
+    if (level == "error") return LogLevel::ERROR;
+    return LogLevel::INFO;
+}
+
+void ServerLog::Init(const ServerLogOptions &options) {
+    Logger &logger = Logger::instance();
+    LogRotateOptions rotate;
+    rotate.dir = options.dir;
+    rotate.base = options.base;
+    rotate.max_bytes = options.max_bytes;
+    logger.setRotateOptions(rotate);
+    // 目录/文件名变了的话让后台线程按新配置重开
+    logger.reopen();
+    logger.setLevel(ParseLevel(options.level));
+    SetTraceEnabled(options.trace);
+}
+
+void ServerLog::Shutdown() { Logger::instance().stop(); }
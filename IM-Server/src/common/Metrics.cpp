@@ -0,0 +1,268 @@
+#include "common/Metrics.h"
+
+#include <cmath>
+#include <cstdio>
+
+size_t MetricShard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard =
+        next.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+int64_t Counter::Value() const {
+    int64_t total = 0;
+    for (const MetricCell &cell : cells_) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+int64_t Gauge::Value() const {
+    int64_t total = 0;
+    for (const MetricCell &cell : cells_) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram() : shards_(new Shard[kMetricShards]) {
+    for (size_t i = 0; i < kMetricShards; ++i) {
+        for (std::atomic<uint64_t> &count : shards_[i].counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        shards_[i].sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 不含 0 桶的下标：x < 8 各占一桶，之后每个 2 的幂区间 8 个桶
+static size_t RawIndex(uint64_t x) {
+    const uint64_t sub = 1u << Histogram::kSubBits;
+    if (x < sub) return static_cast<size_t>(x);
+    int msb = 63 - __builtin_clzll(x);
+    if (msb >= Histogram::kMaxBits) return Histogram::kBuckets - 2;
+    int shift = msb - Histogram::kSubBits;
+    return static_cast<size_t>((shift + 1) * sub + ((x >> shift) & (sub - 1)));
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    // 按 value-1 落桶，桶的上界正好是 2 的幂，导出时 le 不用估算
+    return value == 0 ? 0 : 1 + RawIndex(value - 1);
+}
+
+uint64_t Histogram::BucketUpper(size_t index) {
+    if (index == 0) return 0;
+    size_t raw = index - 1;
+    const size_t sub = 1u << kSubBits;
+    if (raw < sub) return raw + 1;
+    int shift = static_cast<int>(raw / sub) - 1;
+    uint64_t lower = static_cast<uint64_t>(sub + raw % sub) << shift;
+    return lower + (static_cast<uint64_t>(1) << shift);
+}
+
+Histogram::Snapshot Histogram::Collect() const {
+    Snapshot snapshot;
+    snapshot.counts.assign(kBuckets, 0);
+    for (size_t i = 0; i < kMetricShards; ++i) {
+        for (size_t b = 0; b < kBuckets; ++b) {
+            snapshot.counts[b] +=
+                shards_[i].counts[b].load(std::memory_order_relaxed);
+        }
+        snapshot.sum += shards_[i].sum.load(std::memory_order_relaxed);
+    }
+    for (uint64_t count : snapshot.counts) snapshot.count += count;
+    return snapshot;
+}
+
+uint64_t Histogram::Snapshot::CountAtMost(uint64_t value) const {
+    uint64_t total = 0;
+    for (size_t b = 0; b < counts.size() && BucketUpper(b) <= value; ++b) {
+        total += counts[b];
+    }
+    return total;
+}
+
+uint64_t Histogram::Snapshot::Quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * count));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < counts.size(); ++b) {
+        seen += counts[b];
+        if (seen >= rank) return BucketUpper(b);
+    }
+    return BucketUpper(counts.size() - 1);
+}
+
+MetricsRegistry &MetricsRegistry::GetInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::Series *MetricsRegistry::FindOrAdd(const std::string &name,
+                                                    const std::string &help,
+                                                    const std::string &labels,
+                                                    Type type, double scale) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        Family family;
+        family.type = type;
+        family.help = help;
+        family.scale = scale;
+        it = families_.emplace(name, std::move(family)).first;
+    }
+    // 同名不同类型是写错了，不能混在一个 family 里导出
+    if (it->second.type != type) return nullptr;
+    for (auto &series : it->second.series) {
+        if (series->labels == labels) return series.get();
+    }
+    it->second.series.emplace_back(new Series);
+    Series *series = it->second.series.back().get();
+    series->labels = labels;
+    return series;
+}
+
+Counter *MetricsRegistry::GetCounter(const std::string &name,
+                                     const std::string &help,
+                                     const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series *series = FindOrAdd(name, help, labels, Type::kCounter, 1.0);
+    if (series == nullptr) return nullptr;
+    if (!series->counter) series->counter.reset(new Counter);
+    return series->counter.get();
+}
+
+Gauge *MetricsRegistry::GetGauge(const std::string &name,
+                                 const std::string &help,
+                                 const std::string &labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series *series = FindOrAdd(name, help, labels, Type::kGauge, 1.0);
+    if (series == nullptr) return nullptr;
+    if (!series->gauge) series->gauge.reset(new Gauge);
+    return series->gauge.get();
+}
+
+Histogram *MetricsRegistry::GetHistogram(const std::string &name,
+                                         const std::string &help,
+                                         const std::string &labels,
+                                         double scale) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series *series = FindOrAdd(name, help, labels, Type::kHistogram, scale);
+    if (series == nullptr) return nullptr;
+    if (!series->histogram) series->histogram.reset(new Histogram);
+    return series->histogram.get();
+}
+
+void MetricsRegistry::AddCounterFunc(const std::string &name,
+                                     const std::string &help,
+                                     const std::string &labels,
+                                     ValueFunc func) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series *series = FindOrAdd(name, help, labels, Type::kCounter, 1.0);
+    if (series != nullptr) series->func = std::move(func);
+}
+
+void MetricsRegistry::AddGaugeFunc(const std::string &name,
+                                   const std::string &help,
+                                   const std::string &labels,
+                                   ValueFunc func) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series *series = FindOrAdd(name, help, labels, Type::kGauge, 1.0);
+    if (series != nullptr) series->func = std::move(func);
+}
+
+// 整数照原样输出，免得大计数被 %g 截成科学计数法
+static void AppendValue(std::string &out, double value) {
+    char buf[32];
+    if (std::fabs(value) < 9007199254740992.0 && value == std::floor(value)) {
+        snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+    } else {
+        snprintf(buf, sizeof(buf), "%.9g", value);
+    }
+    out += buf;
+}
+
+static void AppendSample(std::string &out, const std::string &name,
+                         const std::string &labels, const std::string &extra,
+                         double value) {
+    out += name;
+    if (!labels.empty() || !extra.empty()) {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty()) out += ',';
+        out += extra;
+        out += '}';
+    }
+    out += ' ';
+    AppendValue(out, value);
+    out += '\n';
+}
+
+static void AppendHeader(std::string &out, const std::string &name,
+                         const std::string &help, const char *type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+void MetricsRegistry::RenderHistogram(const std::string &name,
+                                      const Family &family,
+                                      const Series &series, std::string &out) {
+    Histogram::Snapshot snapshot = series.histogram->Collect();
+    // 1, 4, 16 ... 4^13，延迟按微秒记的话是 1us ~ 67s
+    for (uint64_t le = 1; le <= (static_cast<uint64_t>(1) << 26); le <<= 2) {
+        char extra[48];
+        snprintf(extra, sizeof(extra), "le=\"%.9g\"", le * family.scale);
+        AppendSample(out, name + "_bucket", series.labels, extra,
+                     static_cast<double>(snapshot.CountAtMost(le)));
+    }
+    AppendSample(out, name + "_bucket", series.labels, "le=\"+Inf\"",
+                 static_cast<double>(snapshot.count));
+    AppendSample(out, name + "_sum", series.labels, "",
+                 snapshot.sum * family.scale);
+    AppendSample(out, name + "_count", series.labels, "",
+                 static_cast<double>(snapshot.count));
+}
+
+std::string MetricsRegistry::Render() const {
+    static const double kQuantiles[] = {0.5, 0.99, 0.999};
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    out.reserve(16384);
+    for (const auto &entry : families_) {
+        const std::string &name = entry.first;
+        const Family &family = entry.second;
+        if (family.type == Type::kHistogram) {
+            AppendHeader(out, name, family.help, "histogram");
+            for (const auto &series : family.series) {
+                RenderHistogram(name, family, *series, out);
+            }
+            // 直方图的分位数由服务端按桶算好，不用在抓取端 histogram_quantile
+            AppendHeader(out, name + "_quantile",
+                         family.help + " (quantile estimate)", "gauge");
+            for (const auto &series : family.series) {
+                Histogram::Snapshot snapshot = series->histogram->Collect();
+                for (double q : kQuantiles) {
+                    char extra[32];
+                    snprintf(extra, sizeof(extra), "quantile=\"%g\"", q);
+                    AppendSample(out, name + "_quantile", series->labels, extra,
+                                 snapshot.Quantile(q) * family.scale);
+                }
+            }
+            continue;
+        }
+        AppendHeader(out, name, family.help,
+                     family.type == Type::kCounter ? "counter" : "gauge");
+        for (const auto &series : family.series) {
+            double value = 0;
+            if (series->func) {
+                value = series->func();
+            } else if (series->counter) {
+                value = static_cast<double>(series->counter->Value());
+            } else if (series->gauge) {
+                value = static_cast<double>(series->gauge->Value());
+            }
+            AppendSample(out, name, series->labels, "", value);
+        }
+    }
+    return out;
+}
@@ -1,15 +1,21 @@
 #include <spdlog/spdlog.h>
 
-#include <chrono>
+#include <csignal>
 #include <iostream>
-#include <thread>
 
 #include "business/GroupManager.h"
-#include "business/UserManager.h"
 #include "common/Config.h"
+#include "common/Logging.h"
+#include "network/Compressor.h"
+#include "network/FlowControl.h"
 #include "network/TcpServer.h"
 #include "storage/MySQLManager.h"  // 引入数据库管理器
 #include "storage/RedisManager.h"
+// kill -USR2 <pid> 切换逐事件trace，不用重启
+static void ToggleTrace(int) {
+    ServerLog::SetTraceEnabled(!ServerLog::TraceEnabled());
+}
+
 int main() {
     // 1. 初始化日志
     spdlog::set_level(spdlog::level::debug);
@@ -20,6 +26,32 @@ int main() {
         spdlog::error("Failed to load server.json. Exiting...");
         return 1;
     }
+    // 运行期日志走 MyLog 异步写文件，控制台只留启动信息
+    ServerLogOptions log_options;
+    log_options.dir = Config::GetInstance().GetLogDir();
+    log_options.base = Config::GetInstance().GetLogBase();
+    log_options.level = Config::GetInstance().GetLogLevel();
+    log_options.trace = Config::GetInstance().GetLogTrace();
+    ServerLog::Init(log_options);
+    signal(SIGUSR2, ToggleTrace);
+    spdlog::info("Logging to {}/{}.log, level {}, trace {}.",
+                 log_options.dir, log_options.base, log_options.level,
+                 log_options.trace ? "on" : "off");
+    CompressOptions compress_options;
+    compress_options.enable = Config::GetInstance().GetCompressEnable();
+    compress_options.threshold = Config::GetInstance().GetCompressThreshold();
+    compress_options.acceleration =
+        Config::GetInstance().GetCompressAcceleration();
+    compress_options.stats_interval =
+        Config::GetInstance().GetCompressStatsInterval();
+    Compressor::GetInstance().Init(compress_options);
+    FlowControlOptions flow_options;
+    flow_options.high_water = Config::GetInstance().GetFlowHighWater();
+    flow_options.low_water = Config::GetInstance().GetFlowLowWater();
+    flow_options.hard_limit = Config::GetInstance().GetFlowHardLimit();
+    flow_options.global_budget = Config::GetInstance().GetFlowGlobalBudget();
+    flow_options.policy = Config::GetInstance().GetFlowPolicy();
+    FlowControl::GetInstance().Init(flow_options);
 
     // 3. 【重点测试区域】初始化数据库并测试查表
     bool db_ready = MySQLManager::GetInstance().Init(
@@ -57,19 +89,51 @@ int main() {
     uint16_t port = Config::GetInstance().GetServerPort();
     spdlog::info("Config loaded. Server will bind to {}:{}", ip, port);
 
-    // 增加后台巡逻兵线程
-    std::thread watchdog([]() {
-        spdlog::info("Heartbeat watchdog thread start.");
-        while (true) {
-            std::this_thread::sleep_for(std::chrono::seconds(10));
-            UserManager::GetInstance().CheckTimeouts(30);
-        }
-    });
     try {
-        TcpServer server(ip, port);
+        TcpServerOptions options;
+        options.io_threads = Config::GetInstance().GetIoThreads();
+        options.balance_policy = Config::GetInstance().GetBalancePolicy();
+        options.backlog = Config::GetInstance().GetBacklog();
+        options.reuseport_shards = Config::GetInstance().GetReuseportShards();
+        options.cpu_steering = Config::GetInstance().GetCpuSteering();
+        options.idle_timeout = Config::GetInstance().GetHeartbeatTimeout();
+        options.cork_mode = Config::GetInstance().GetCorkMode();
+        options.poller = Config::GetInstance().GetPoller();
+        options.trigger_mode = Config::GetInstance().GetTriggerMode();
+        options.accept.batch = Config::GetInstance().GetAcceptBatch();
+        options.accept.rate = Config::GetInstance().GetAcceptRate();
+        options.accept.burst = Config::GetInstance().GetAcceptBurst();
+        SocketOptions &socket = options.accept.socket;
+        socket.no_delay = Config::GetInstance().GetSocketNoDelay();
+        socket.send_buf = Config::GetInstance().GetSocketSendBuf();
+        socket.recv_buf = Config::GetInstance().GetSocketRecvBuf();
+        socket.quick_ack = Config::GetInstance().GetSocketQuickAck();
+        socket.busy_poll_us = Config::GetInstance().GetSocketBusyPoll();
+        socket.user_timeout_ms = Config::GetInstance().GetSocketUserTimeout();
+        socket.keepalive = Config::GetInstance().GetSocketKeepalive();
+        socket.keepalive_idle = Config::GetInstance().GetSocketKeepaliveIdle();
+        socket.keepalive_interval =
+            Config::GetInstance().GetSocketKeepaliveInterval();
+        socket.keepalive_count = Config::GetInstance().GetSocketKeepaliveCount();
+        options.loop_spin_us = Config::GetInstance().GetLoopSpin();
+        options.upgrade_path = Config::GetInstance().GetUpgradePath();
+        options.drain_timeout = Config::GetInstance().GetDrainTimeout();
+        options.admin_ip = Config::GetInstance().GetAdminIp();
+        options.admin_port =
+            static_cast<uint16_t>(Config::GetInstance().GetAdminPort());
+        spdlog::info("Socket preset {}: nodelay {}, quickack {}, "
+                     "busy_poll {}us, loop spin {}us",
+                     Config::GetInstance().GetSocketPreset(), socket.no_delay,
+                     socket.quick_ack, socket.busy_poll_us,
+                     options.loop_spin_us);
+        // 数据库、群组、Redis 都准备好了才构造 TcpServer：
+        // 有旧进程在跑时，到这里才去领它的监听socket
+        TcpServer server(ip, port, options);
         server.start();
     } catch (const std::exception &e) {
         spdlog::critical("Server crashed: {}", e.what());
+        IM_ERROR("Server crashed: %s", e.what());
+        ServerLog::Shutdown();
         return 1;
     }
     return 0;
@@ -0,0 +1,145 @@
+#include "network/Acceptor.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include "common/CoarseClock.h"
+#include "common/Logging.h"
+
+std::atomic<uint64_t> Acceptor::accepted_{0};
+std::atomic<uint64_t> Acceptor::shed_{0};
+std::atomic<uint64_t> Acceptor::throttled_{0};
+std::atomic<uint64_t> Acceptor::fd_paused_{0};
+
+static int64_t MonotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int OpenIdleFd() { return open("/dev/null", O_RDONLY | O_CLOEXEC); }
+
+Acceptor::Acceptor(EventLoop *loop, int listen_fd,
+                   const AcceptorOptions &options)
+    : loop_(loop),
+      listen_fd_(listen_fd),
+      channel_(loop, listen_fd),
+      options_(options),
+      idle_fd_(OpenIdleFd()),
+      last_refill_ms_(MonotonicMs()) {
+    if (options_.batch == 0) options_.batch = 1;
+    if (options_.rate > 0 && options_.burst <= 0) {
+        options_.burst = std::max(options_.rate, 1.0);
+    }
+    tokens_ = options_.burst;
+    if (idle_fd_ == -1) {
+        IM_WARN("Open reserve fd failed: %s", strerror(errno));
+    }
+    channel_.SetEventCallback([this](uint32_t) { this->HandleRead(); });
+    resume_timer_.callback = [this] { this->Resume(); };
+}
+
+Acceptor::~Acceptor() {
+    // loop 此时可能已经析构，不再碰 channel 和定时器
+    if (idle_fd_ != -1) close(idle_fd_);
+}
+
+void Acceptor::Listen() { channel_.EnableReading(); }
+
+void Acceptor::Stop() {
+    loop_->GetTimerWheel().Remove(&resume_timer_);
+    channel_.Remove();
+}
+
+Acceptor::Stats Acceptor::GetStats() {
+    Stats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.shed = shed_.load(std::memory_order_relaxed);
+    stats.throttled = throttled_.load(std::memory_order_relaxed);
+    stats.fd_paused = fd_paused_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Acceptor::HandleRead() {
+    for (size_t i = 0; i < options_.batch; ++i) {
+        if (options_.rate > 0) {
+            if (tokens_ < 1) Refill();
+            if (tokens_ < 1) {
+                Pause(false);
+                return;
+            }
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            tokens_ -= 1;
+            accepted_.fetch_add(1, std::memory_order_relaxed);
+            ApplySocketOptions(fd, options_.socket);
+            IM_DEBUG("New Client Connected! fd: %d", fd);
+            new_connection_callback_(fd);
+            continue;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        if (errno == EMFILE || errno == ENFILE) {
+            ShedOne();
+            if (!channel_.IsReading()) return;
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            IM_ERROR("accept4 failed on fd %d: %s", listen_fd_,
+                     strerror(errno));
+        }
+        return;
+    }
+}
+
+void Acceptor::ShedOne() {
+    time_t now = CoarseClock::Now();
+    if (now != last_shed_log_) {
+        last_shed_log_ = now;
+        IM_WARN("Out of fds (%s), shedding new connections",
+                strerror(errno));
+    }
+    if (idle_fd_ == -1) {
+        // 没有预留fd可让，只能先停一下，别让loop空转
+        Pause(true);
+        return;
+    }
+    close(idle_fd_);
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd >= 0) {
+        close(fd);
+        shed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    idle_fd_ = OpenIdleFd();
+}
+
+void Acceptor::Refill() {
+    int64_t now = MonotonicMs();
+    if (now <= last_refill_ms_) return;
+    tokens_ = std::min(options_.burst,
+                       tokens_ + options_.rate * (now - last_refill_ms_) / 1000);
+    last_refill_ms_ = now;
+}
+
+void Acceptor::Pause(bool out_of_fds) {
+    if (resume_timer_.IsLinked()) return;
+    (out_of_fds ? fd_paused_ : throttled_)
+        .fetch_add(1, std::memory_order_relaxed);
+    IM_DEBUG("Accept paused on fd %d", listen_fd_);
+    channel_.DisableReading();
+    // 延迟0：下一个tick就恢复，补充的令牌按实际经过的时间算
+    loop_->GetTimerWheel().Add(&resume_timer_, 0);
+}
+
+void Acceptor::Resume() {
+    Refill();
+    IM_DEBUG("Accept resumed on fd %d, %.0f tokens", listen_fd_, tokens_);
+    channel_.EnableReading();
+}
@@ -0,0 +1,204 @@
+#include "network/AdminServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "common/Logging.h"
+#include "common/Metrics.h"
+
+namespace {
+std::string MakeResponse(const char *status, const char *content_type,
+                         const std::string &body) {
+    std::string response = "HTTP/1.0 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += content_type;
+    response += "\r\nContent-Length: " + std::to_string(body.size()) +
+                "\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+// Channel 可能还在本批就绪事件里，等本轮事件处理完再删
+template <typename T>
+void DeferDelete(EventLoop *loop, std::unique_ptr<T> &owned) {
+    if (!owned) return;
+    T *raw = owned.release();
+    loop->QueueInLoop([raw] { delete raw; });
+}
+}  // namespace
+
+AdminServer::AdminServer(EventLoop *loop, const std::string &ip,
+                         uint16_t port)
+    : loop_(loop), ip_(ip), port_(port) {}
+
+AdminServer::~AdminServer() {
+    // loop 此时可能已经析构，只关fd
+    for (auto &entry : clients_) close(entry.first);
+    if (listen_fd_ != -1) close(listen_fd_);
+}
+
+bool AdminServer::Start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ == -1) return false;
+    int opt = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // 平滑重启时旧进程还占着端口，新进程也要能绑上
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    addr.sin_addr.s_addr = inet_addr(ip_.c_str());
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) == -1 ||
+        listen(listen_fd_, 16) == -1) {
+        IM_WARN("Admin port %s:%u unavailable: %s", ip_.c_str(), port_,
+                strerror(errno));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    listen_channel_.reset(new Channel(loop_, listen_fd_));
+    listen_channel_->SetEventCallback([this](uint32_t) { this->HandleAccept(); });
+    listen_channel_->EnableReading();
+    IM_INFO("Metrics on http://%s:%u/metrics", ip_.c_str(), port_);
+    return true;
+}
+
+void AdminServer::Stop() {
+    while (!clients_.empty()) CloseClient(clients_.begin()->second.get());
+    if (listen_fd_ == -1) return;
+    listen_channel_->Remove();
+    DeferDelete(loop_, listen_channel_);
+    close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void AdminServer::HandleAccept() {
+    // Stop 之后本批里可能还有监听socket的事件
+    if (listen_fd_ == -1) return;
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                IM_WARN("Admin accept failed: %s", strerror(errno));
+            }
+            return;
+        }
+        if (clients_.size() >= kMaxClients) {
+            close(fd);
+            continue;
+        }
+        Client *client = new Client;
+        client->fd = fd;
+        clients_[fd].reset(client);
+        client->channel.reset(new Channel(loop_, fd));
+        client->channel->SetEventCallback([this, client](uint32_t revents) {
+            this->HandleClient(client, revents);
+        });
+        client->idle_timer.callback = [this, client] {
+            this->CloseClient(client);
+        };
+        loop_->GetTimerWheel().Add(&client->idle_timer, kIdleTicks);
+        client->channel->EnableReading();
+    }
+}
+
+void AdminServer::HandleClient(Client *client, uint32_t revents) {
+    if (client->closed) return;
+    if (revents & EPOLLOUT) {
+        if (WriteResponse(client)) CloseClient(client);
+        return;
+    }
+    if (!client->response.empty()) return;  // 已经在回了，忽略多发的
+    char buf[2048];
+    while (true) {
+        ssize_t n = read(client->fd, buf, sizeof(buf));
+        if (n > 0) {
+            client->request.append(buf, n);
+            if (client->request.find("\r\n\r\n") != std::string::npos ||
+                client->request.size() > kMaxRequest) {
+                Respond(client);
+                return;
+            }
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        // 对端关了或者出错
+        CloseClient(client);
+        return;
+    }
+}
+
+void AdminServer::Respond(Client *client) {
+    const std::string &request = client->request;
+    std::string line = request.substr(0, request.find("\r\n"));
+    if (request.size() > kMaxRequest) {
+        client->response =
+            MakeResponse("431 Request Header Fields Too Large", "text/plain",
+                         "request too large\n");
+    } else if (line.compare(0, 4, "GET ") != 0) {
+        client->response = MakeResponse("405 Method Not Allowed", "text/plain",
+                                        "only GET is supported\n");
+    } else {
+        std::string path = line.substr(4, line.find(' ', 4) - 4);
+        if (path == "/metrics" || path == "/") {
+            client->response = MakeResponse(
+                "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                MetricsRegistry::GetInstance().Render());
+        } else {
+            client->response =
+                MakeResponse("404 Not Found", "text/plain", "not found\n");
+        }
+    }
+    client->request.clear();
+    if (WriteResponse(client)) {
+        CloseClient(client);
+        return;
+    }
+    // 没写完，等可写再接着写
+    client->channel->DisableReading();
+    client->channel->EnableWriting();
+}
+
+bool AdminServer::WriteResponse(Client *client) {
+    while (client->sent < client->response.size()) {
+        ssize_t n = send(client->fd, client->response.data() + client->sent,
+                         client->response.size() - client->sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            client->sent += n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        return true;  // 出错也当成结束，直接关
+    }
+    return true;
+}
+
+void AdminServer::CloseClient(Client *client) {
+    if (client->closed) return;
+    client->closed = true;
+    loop_->GetTimerWheel().Remove(&client->idle_timer);
+    client->channel->Remove();
+    auto it = clients_.find(client->fd);
+    if (it != clients_.end() && it->second.get() == client) {
+        it->second.release();
+        clients_.erase(it);
+    }
+    // fd 和对象一起等本轮事件处理完再释放：在那之前fd号不会被新连接复用，
+    // 本批里残留的旧事件也碰不到别的连接
+    loop_->QueueInLoop([client] {
+        close(client->fd);
+        delete client;
+    });
+}
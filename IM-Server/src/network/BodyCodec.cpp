@@ -0,0 +1,307 @@
+#include "network/BodyCodec.h"
+
+#include "network/Codec.h"
+#include "network/Compressor.h"
+
+using json = nlohmann::json;
+
+// JSON 里的键名，下标是 Field
+static const char *const kFieldNames[] = {
+    "",     "cmd",      "code",  "msg",  "username", "password", "to",
+    "from", "group_id", "users", "time", "status",   "binary", "compress",
+};
+static_assert(sizeof(kFieldNames) / sizeof(kFieldNames[0]) ==
+                  static_cast<size_t>(Field::kMaxField),
+              "kFieldNames out of sync with Field");
+
+// JSON 里的 cmd 字符串，下标是 Cmd
+static const char *const kCmdNames[] = {
+    "",
+    "login",
+    "login_resp",
+    "chat",
+    "group_chat",
+    "push_chat",
+    "push_group_chat",
+    "presence",
+    "presence_resp",
+};
+static_assert(sizeof(kCmdNames) / sizeof(kCmdNames[0]) ==
+                  static_cast<size_t>(Cmd::kMaxCmd),
+              "kCmdNames out of sync with Cmd");
+
+static const unsigned kWireVarint = 0;
+static const unsigned kWireBytes = 2;
+
+static const char *FieldName(Field field) {
+    return kFieldNames[static_cast<size_t>(field)];
+}
+
+// 要转发或者存下来的文本字段；kStatus 里带着原始的布尔字节，不算文本
+static bool IsTextField(uint64_t tag) {
+    switch (static_cast<Field>(tag)) {
+        case Field::kMsg:
+        case Field::kUsername:
+        case Field::kPassword:
+        case Field::kTo:
+        case Field::kFrom:
+        case Field::kUsers:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// 严格的 UTF-8：拒绝过长编码、代理区和超过 U+10FFFF 的码点
+static bool IsValidUtf8(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        uint8_t c = static_cast<uint8_t>(text[i]);
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t len;
+        uint32_t lower = 0x80, upper = 0xBF;  // 第二个字节的范围
+        if (c >= 0xC2 && c <= 0xDF) {
+            len = 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            len = 3;
+            if (c == 0xE0) lower = 0xA0;
+            if (c == 0xED) upper = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            len = 4;
+            if (c == 0xF0) lower = 0x90;
+            if (c == 0xF4) upper = 0x8F;
+        } else {
+            return false;
+        }
+        if (i + len > text.size()) return false;
+        uint8_t second = static_cast<uint8_t>(text[i + 1]);
+        if (second < lower || second > upper) return false;
+        for (size_t k = 2; k < len; ++k) {
+            if ((static_cast<uint8_t>(text[i + k]) & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += len;
+    }
+    return true;
+}
+
+void varint::Append(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+size_t varint::Read(std::string_view in, uint64_t &value) {
+    value = 0;
+    for (size_t i = 0; i < in.size() && i < 10; ++i) {
+        uint8_t byte = static_cast<uint8_t>(in[i]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) return i + 1;
+    }
+    return 0;
+}
+
+// 逐个遍历二进制字段，回调返回 false 提前结束；包体不合法返回 false
+template <typename Fn>
+static bool ForEachField(std::string_view body, Fn fn) {
+    while (!body.empty()) {
+        uint64_t key = 0;
+        size_t n = varint::Read(body, key);
+        if (n == 0) return false;
+        body.remove_prefix(n);
+        uint64_t number = 0;
+        n = varint::Read(body, number);
+        if (n == 0) return false;
+        body.remove_prefix(n);
+        unsigned wire = key & 0x7;
+        std::string_view bytes;
+        if (wire == kWireBytes) {
+            if (number > body.size()) return false;
+            bytes = body.substr(0, number);
+            body.remove_prefix(number);
+        } else if (wire != kWireVarint) {
+            return false;
+        }
+        if (!fn(key >> 3, wire == kWireVarint, number, bytes)) break;
+    }
+    return true;
+}
+
+bool BodyReader::Parse(BodyFormat format, std::string_view body) {
+    format_ = format;
+    body_ = body;
+    if (format == BodyFormat::kJson) {
+        json_ = json::parse(body.begin(), body.end(), nullptr, false);
+        return !json_.is_discarded() && json_.is_object();
+    }
+    fields_.fill(Value());
+    return ForEachField(body, [this](uint64_t tag, bool is_int,
+                                     uint64_t number, std::string_view bytes) {
+        // 不认识的字段跳过；重复字段这里只记最后一个，GetStrings 再扫一遍
+        if (tag == 0 || tag >= fields_.size()) return true;
+        Value &value = fields_[tag];
+        value.present = true;
+        value.is_int = is_int;
+        value.number = number;
+        value.bytes = bytes;
+        return true;
+    });
+}
+
+Cmd BodyReader::GetCmd() const {
+    if (format_ == BodyFormat::kBinary) {
+        int64_t id = GetInt(Field::kCmd, 0);
+        if (id <= 0 || id >= static_cast<int64_t>(Cmd::kMaxCmd)) {
+            return Cmd::kUnknown;
+        }
+        return static_cast<Cmd>(id);
+    }
+    std::string_view name = GetString(Field::kCmd);
+    for (size_t i = 1; i < static_cast<size_t>(Cmd::kMaxCmd); ++i) {
+        if (name == kCmdNames[i]) return static_cast<Cmd>(i);
+    }
+    return Cmd::kUnknown;
+}
+
+bool BodyReader::Has(Field field) const {
+    if (format_ == BodyFormat::kBinary) {
+        return fields_[static_cast<size_t>(field)].present;
+    }
+    return json_.contains(FieldName(field));
+}
+
+std::string_view BodyReader::GetString(Field field) const {
+    if (format_ == BodyFormat::kBinary) {
+        const Value &value = fields_[static_cast<size_t>(field)];
+        return value.present && !value.is_int ? value.bytes
+                                              : std::string_view();
+    }
+    auto it = json_.find(FieldName(field));
+    if (it == json_.end() || !it->is_string()) return std::string_view();
+    return it->get_ref<const std::string &>();
+}
+
+int64_t BodyReader::GetInt(Field field, int64_t default_value) const {
+    if (format_ == BodyFormat::kBinary) {
+        const Value &value = fields_[static_cast<size_t>(field)];
+        return value.present && value.is_int
+                   ? static_cast<int64_t>(value.number)
+                   : default_value;
+    }
+    auto it = json_.find(FieldName(field));
+    if (it == json_.end()) return default_value;
+    if (it->is_number_integer()) return it->get<int64_t>();
+    if (it->is_boolean()) return it->get<bool>() ? 1 : 0;
+    return default_value;
+}
+
+bool BodyReader::GetStrings(Field field,
+                            std::vector<std::string_view> &values) const {
+    values.clear();
+    if (format_ == BodyFormat::kBinary) {
+        uint64_t want = static_cast<uint64_t>(field);
+        ForEachField(body_, [&](uint64_t tag, bool is_int, uint64_t,
+                                std::string_view bytes) {
+            if (tag == want && !is_int) values.push_back(bytes);
+            return true;
+        });
+        return true;
+    }
+    auto it = json_.find(FieldName(field));
+    if (it == json_.end() || !it->is_array()) return false;
+    values.reserve(it->size());
+    for (const auto &item : *it) {
+        if (item.is_string()) {
+            values.push_back(item.get_ref<const std::string &>());
+        }
+    }
+    return true;
+}
+
+bool BodyReader::TextValid() const {
+    if (format_ == BodyFormat::kJson) return true;
+    bool valid = true;
+    ForEachField(body_, [&valid](uint64_t tag, bool is_int, uint64_t,
+                                 std::string_view bytes) {
+        if (!is_int && IsTextField(tag) && !IsValidUtf8(bytes)) valid = false;
+        return valid;
+    });
+    return valid;
+}
+
+BodyWriter &BodyWriter::SetCmd(Cmd cmd) {
+    if (format_ == BodyFormat::kBinary) {
+        return SetInt(Field::kCmd, static_cast<int64_t>(cmd));
+    }
+    json_[FieldName(Field::kCmd)] = kCmdNames[static_cast<size_t>(cmd)];
+    return *this;
+}
+
+BodyWriter &BodyWriter::SetInt(Field field, int64_t value) {
+    if (format_ == BodyFormat::kBinary) {
+        varint::Append(binary_,
+                       static_cast<uint64_t>(field) << 3 | kWireVarint);
+        varint::Append(binary_, static_cast<uint64_t>(value));
+        return *this;
+    }
+    json_[FieldName(field)] = value;
+    return *this;
+}
+
+BodyWriter &BodyWriter::SetString(Field field, std::string_view value) {
+    if (format_ == BodyFormat::kBinary) {
+        varint::Append(binary_,
+                       static_cast<uint64_t>(field) << 3 | kWireBytes);
+        varint::Append(binary_, value.size());
+        binary_.append(value.data(), value.size());
+        return *this;
+    }
+    json_[FieldName(field)] = std::string(value);
+    return *this;
+}
+
+BodyWriter &BodyWriter::AddStatus(Field field, std::string_view name,
+                                  bool value) {
+    if (format_ == BodyFormat::kBinary) {
+        // 值：varint(名字长度) + 名字 + 1字节布尔
+        std::string entry;
+        varint::Append(entry, name.size());
+        entry.append(name.data(), name.size());
+        entry.push_back(value ? 1 : 0);
+        return SetString(field, entry);
+    }
+    json &status = json_[FieldName(field)];
+    if (!status.is_object()) status = json::object();
+    status[std::string(name)] = value;
+    return *this;
+}
+
+BodyWriter &BodyWriter::SetEmptyMap(Field field) {
+    if (format_ == BodyFormat::kJson) {
+        json_[FieldName(field)] = json::object();
+    }
+    return *this;
+}
+
+std::string BodyWriter::Body() const {
+    // 请求里的文本已经在 TextValid 查过；库里存着的旧数据万一不合法，
+    // 替换成 U+FFFD 照样发出去，不能因为一个字节让整条推送失败
+    return format_ == BodyFormat::kBinary
+               ? binary_
+               : json_.dump(-1, ' ', false, json::error_handler_t::replace);
+}
+
+std::string BodyWriter::Pack(uint32_t msg_type, bool compress) const {
+    std::string body = Body();
+    if (format_ == BodyFormat::kBinary) msg_type |= Codec::kBinaryBody;
+    if (compress && Compressor::GetInstance().Compress(body)) {
+        msg_type |= Codec::kCompressed;
+    }
+    return Codec::PackMessage(msg_type, body);
+}
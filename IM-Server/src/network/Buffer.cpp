@@ -1,11 +1,56 @@
 #include "network/Buffer.h"
 
-void Buffer::Append(const char *data, size_t len) { buf_.append(data, len); }
+#include <sys/uio.h>
+
+#include <cerrno>
+
+void Buffer::Append(const char *data, size_t len) {
+    EnsureWritable(len);
+    std::copy(data, data + len, BeginWrite());
+    HasWritten(len);
+}
 
 std::string Buffer::RetrieveAllAsString() {
-    std::string result = buf_;
-    buf_.clear();
-    return result;
+    return RetrieveAsString(ReadableBytes());
 }
 
-size_t Buffer::ReadableBytes() const { return buf_.size(); }
\ No newline at end of file
+void Buffer::MakeSpace(size_t len) {
+    if (WritableBytes() + PrependableBytes() < len + kCheapPrepend) {
+        // 总空闲也不够，只能扩容：至少翻倍，均摊 O(1)；只搬可读数据
+        size_t want = std::max(capacity_ * 2, writer_index_ + len);
+        size_t capacity = BlockPool::BlockSize(want);
+        char *data = static_cast<char *>(BlockPool::Allocate(capacity));
+        std::copy(Begin() + reader_index_, Begin() + writer_index_,
+                  data + reader_index_);
+        BlockPool::Deallocate(data_, capacity_);
+        data_ = data;
+        capacity_ = capacity;
+    } else {
+        // 前面被读走的空间够用：把可读数据挪回 kCheapPrepend 处
+        size_t readable = ReadableBytes();
+        std::copy(Begin() + reader_index_, Begin() + writer_index_,
+                  Begin() + kCheapPrepend);
+        reader_index_ = kCheapPrepend;
+        writer_index_ = reader_index_ + readable;
+    }
+}
+
+ssize_t Buffer::ReadFd(int fd, int *saved_errno) {
+    char extrabuf[kExtraBufSize];
+    struct iovec vec[2];
+    const size_t writable = WritableBytes();
+    vec[0].iov_base = BeginWrite();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extrabuf;
+    vec[1].iov_len = sizeof(extrabuf);
+    const ssize_t n = readv(fd, vec, 2);
+    if (n < 0) {
+        *saved_errno = errno;
+    } else if (static_cast<size_t>(n) <= writable) {
+        HasWritten(n);
+    } else {
+        writer_index_ = capacity_;
+        Append(extrabuf, n - writable);
+    }
+    return n;
+}
@@ -0,0 +1,36 @@
+#include "network/Channel.h"
+
+#include "network/EventLoop.h"
+
+Channel::Channel(EventLoop *loop, int fd)
+    : loop_(loop),
+      fd_(fd),
+      events_(0),
+      mode_(TriggerMode::kLevel),
+      added_(false),
+      armed_(false),
+      dirty_(false) {}
+
+void Channel::Update() { loop_->UpdateChannel(this); }
+
+void Channel::Remove() {
+    events_ = 0;
+    loop_->RemoveChannel(this);
+}
+
+TriggerMode ParseTriggerMode(const std::string &name) {
+    if (name == "edge") return TriggerMode::kEdge;
+    if (name == "oneshot") return TriggerMode::kOneShot;
+    return TriggerMode::kLevel;
+}
+
+const char *TriggerModeName(TriggerMode mode) {
+    switch (mode) {
+        case TriggerMode::kEdge:
+            return "edge";
+        case TriggerMode::kOneShot:
+            return "oneshot";
+        default:
+            return "level";
+    }
+}
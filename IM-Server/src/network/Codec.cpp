@@ -4,8 +4,7 @@
 
 #include <algorithm>
 
-bool Codec::ParseMessage(Buffer *buffer, uint32_t &out_msg_type,
-                         std::string &out_msg_body) {
+bool Codec::PeekFrame(const Buffer *buffer, Frame &frame) {
     // 1、检查buffer数据是否足够一个包头（8B），不够就是半包
     if (buffer->ReadableBytes() < sizeof(MsgHeader)) {
         return false;
@@ -21,11 +20,28 @@ bool Codec::ParseMessage(Buffer *buffer, uint32_t &out_msg_type,
     if (buffer->ReadableBytes() < sizeof(MsgHeader) + length) {
         return false;  // 包体不完整，继续等待接收
     }
-    // 5、完整的包
-    buffer->Retrieve(sizeof(MsgHeader));  // 丢弃8字节包头
+    // 5、完整的包，包体直接引用buffer里的数据
+    uint32_t raw_type = ntohl(header.msg_type);
+    frame.msg_type = raw_type & ~kFlagMask;
+    frame.flags = raw_type & kFlagMask;
+    frame.body = std::string_view(data + sizeof(MsgHeader), length);
+    return true;
+}
+
+void Codec::RetrieveFrame(Buffer *buffer, const Frame &frame) {
+    buffer->Retrieve(sizeof(MsgHeader) + frame.body.size());
+}
+
+bool Codec::ParseMessage(Buffer *buffer, uint32_t &out_msg_type,
+                         std::string &out_msg_body) {
+    Frame frame;
+    if (!PeekFrame(buffer, frame)) {
+        return false;
+    }
     // 赋值给传出数据
-    out_msg_type = ntohl(header.msg_type);
-    out_msg_body = buffer->RetrieveAsString(length);
+    out_msg_type = frame.msg_type;
+    out_msg_body.assign(frame.body.data(), frame.body.size());
+    RetrieveFrame(buffer, frame);
     return true;
 }
 
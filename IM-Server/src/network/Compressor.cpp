@@ -0,0 +1,159 @@
+#include "network/Compressor.h"
+
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "common/CoarseClock.h"
+#include "common/Logging.h"
+#ifdef IM_HAVE_LZ4
+#include <lz4.h>
+
+// 原始长度前缀
+static const size_t kLengthPrefix = sizeof(uint32_t);
+
+static uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+#endif
+
+Compressor &Compressor::GetInstance() {
+    static Compressor instance;
+    return instance;
+}
+
+void Compressor::Init(const CompressOptions &options) {
+    enable_ = options.enable;
+    threshold_ = options.threshold;
+    acceleration_ = options.acceleration > 0 ? options.acceleration : 1;
+    stats_interval_ = options.stats_interval;
+#ifndef IM_HAVE_LZ4
+    if (enable_) {
+        IM_WARN("compression enabled in config but built without lz4, off.");
+    }
+#endif
+    IM_INFO("compression %s, threshold %zu bytes, acceleration %d",
+            Available() ? "on" : "off", threshold_, acceleration_);
+}
+
+bool Compressor::Available() const {
+#ifdef IM_HAVE_LZ4
+    return enable_;
+#else
+    return false;
+#endif
+}
+
+bool Compressor::Compress(std::string &body) {
+#ifdef IM_HAVE_LZ4
+    if (!enable_ || body.size() > kMaxRawLength) return false;
+    if (body.size() < threshold_) {
+        skipped_small_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    int bound = LZ4_compressBound(static_cast<int>(body.size()));
+    std::string packed(kLengthPrefix + bound, '\0');
+    uint32_t raw_length = htonl(static_cast<uint32_t>(body.size()));
+    std::memcpy(&packed[0], &raw_length, kLengthPrefix);
+    int n = LZ4_compress_fast(body.data(), &packed[kLengthPrefix],
+                              static_cast<int>(body.size()), bound,
+                              acceleration_);
+    compress_ns_.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+    bool smaller = n > 0 && kLengthPrefix + n < body.size();
+    if (smaller) {
+        packed.resize(kLengthPrefix + n);
+        compressed_.fetch_add(1, std::memory_order_relaxed);
+        raw_bytes_.fetch_add(body.size(), std::memory_order_relaxed);
+        packed_bytes_.fetch_add(packed.size(), std::memory_order_relaxed);
+        body.swap(packed);
+    } else {
+        skipped_ratio_.fetch_add(1, std::memory_order_relaxed);
+    }
+    MaybeReport();
+    return smaller;
+#else
+    (void)body;
+    return false;
+#endif
+}
+
+bool Compressor::Decompress(std::string_view in, std::string &out) {
+#ifdef IM_HAVE_LZ4
+    auto start = std::chrono::steady_clock::now();
+    uint32_t raw_length = 0;
+    bool ok = in.size() >= kLengthPrefix;
+    if (ok) {
+        std::memcpy(&raw_length, in.data(), kLengthPrefix);
+        raw_length = ntohl(raw_length);
+        ok = raw_length <= kMaxRawLength;
+    }
+    if (ok) {
+        out.resize(raw_length);
+        int n = LZ4_decompress_safe(in.data() + kLengthPrefix, &out[0],
+                                    static_cast<int>(in.size() - kLengthPrefix),
+                                    static_cast<int>(raw_length));
+        ok = n >= 0 && static_cast<uint32_t>(n) == raw_length;
+    }
+    if (ok) {
+        decompressed_.fetch_add(1, std::memory_order_relaxed);
+        decompress_ns_.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+    } else {
+        decompress_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    MaybeReport();
+    return ok;
+#else
+    (void)in;
+    (void)out;
+    decompress_errors_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+#endif
+}
+
+Compressor::Stats Compressor::GetStats() const {
+    Stats stats;
+    stats.compressed = compressed_.load(std::memory_order_relaxed);
+    stats.skipped_small = skipped_small_.load(std::memory_order_relaxed);
+    stats.skipped_ratio = skipped_ratio_.load(std::memory_order_relaxed);
+    stats.raw_bytes = raw_bytes_.load(std::memory_order_relaxed);
+    stats.packed_bytes = packed_bytes_.load(std::memory_order_relaxed);
+    stats.compress_ns = compress_ns_.load(std::memory_order_relaxed);
+    stats.decompressed = decompressed_.load(std::memory_order_relaxed);
+    stats.decompress_ns = decompress_ns_.load(std::memory_order_relaxed);
+    stats.decompress_errors =
+        decompress_errors_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Compressor::MaybeReport() {
+    if (stats_interval_ <= 0) return;
+    time_t now = CoarseClock::Now();
+    time_t next = next_report_.load(std::memory_order_relaxed);
+    if (now < next) return;
+    if (!next_report_.compare_exchange_strong(next, now + stats_interval_,
+                                              std::memory_order_relaxed)) {
+        return;
+    }
+    // 第一次调用只定下一次的时间
+    if (next == 0) return;
+    Stats s = GetStats();
+    double ratio = s.raw_bytes ? static_cast<double>(s.packed_bytes) /
+                                     static_cast<double>(s.raw_bytes)
+                               : 1.0;
+    uint64_t attempts = s.compressed + s.skipped_ratio;
+    IM_INFO("[compress] frames %llu (small %llu, incompressible %llu), "
+            "ratio %.3f, saved %llu bytes, avg %.1f us; inflate %llu, "
+            "avg %.1f us, errors %llu",
+            static_cast<unsigned long long>(s.compressed),
+            static_cast<unsigned long long>(s.skipped_small),
+            static_cast<unsigned long long>(s.skipped_ratio), ratio,
+            static_cast<unsigned long long>(s.raw_bytes - s.packed_bytes),
+            attempts ? s.compress_ns / 1000.0 / attempts : 0.0,
+            static_cast<unsigned long long>(s.decompressed),
+            s.decompressed ? s.decompress_ns / 1000.0 / s.decompressed : 0.0,
+            static_cast<unsigned long long>(s.decompress_errors));
+}
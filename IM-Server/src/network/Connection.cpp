@@ -1,310 +1,361 @@
 #include "network/Connection.h"
 
-#include <fcntl.h>
-#include <spdlog/spdlog.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <cstring>
-#include <iostream>
 #include <chrono>
+#include <unordered_map>
 #include "business/UserManager.h"
-#include "common/json.hpp"
+#include "common/Logging.h"
+#include "common/Metrics.h"
 #include "network/Codec.h"
-#include "storage/MySQLManager.h"
-#include "business/GroupManager.h"
+#include "network/Compressor.h"
+#include "network/FlowControl.h"
+#include "network/MessageDispatcher.h"
+#include "network/SocketOptions.h"
 #include "storage/RedisManager.h"
-using json = nlohmann::json;
-static void SetNonBlocking(int fd) {
-    int flags = fcntl(fd, F_GETFL, 0);
-    if (flags == -1) {
-        std::cerr << "fcntl get failed" << std::endl;
-        return;
+
+Connection::Connection(EventLoop *loop, int fd)
+    : loop_(loop),
+      fd_(fd),
+      channel_(loop, fd),
+      strand_(std::allocate_shared<Strand>(PoolAllocator<Strand>())) {
+    // 回调只绑定一次，之后切换读写关注只改事件掩码
+    channel_.SetEventCallback(
+        [this](uint32_t revents) { this->HandleEvent(revents); });
+    channel_.SetFlushCallback([this] { this->Flush(); });
+}
+
+Connection::~Connection() {
+    // 没写出去的字节从全局预算里还回去
+    output_queue_.Clear();
+    SyncOutputBudget();
+    close(fd_);
+    IM_DEBUG("Connection %d closed and destroyed.", fd_);
+}
+
+void Connection::ConnectEstablished() {
+    if (EdgeTriggered()) {
+        // 读写一次挂上，之后发送不再改注册
+        channel_.EnableReadWrite();
+    } else {
+        channel_.EnableReading();
     }
-    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-        std::cerr << "fcntl set failed" << std::endl;
+    last_active_time_ = CoarseClock::Now();
+    if (idle_timeout_ > 0) {
+        // 节点嵌在Connection里，ConnectDestroyed 时摘下，回调里用this是安全的
+        idle_timer_.callback = [this] { this->HandleIdleTimeout(); };
+        loop_->GetTimerWheel().Add(&idle_timer_, IdleTimeoutTicks());
     }
 }
 
-Connection::Connection(EventLoop *loop, int fd) : loop_(loop), fd_(fd) {
-    SetNonBlocking(fd_);
-    loop_->AddEvent(fd_, EPOLLIN,
-                    [this](uint32_t revents) { this->HandleEvent(revents); });
+void Connection::ConnectDestroyed() {
+    loop_->GetTimerWheel().Remove(&idle_timer_);
+    channel_.Remove();
 }
 
-Connection::~Connection() {
-    loop_->RemoveEvent(fd_);
-    close(fd_);
-    std::cout << "Connection " << fd_ << " closed and destroyed." << std::endl;
+void Connection::HandleIdleTimeout() {
+    IM_WARN("fd %d heartbeat timeout, kicking out.", fd_);
+    // 先关读写让对端立刻感知；fd 等连接对象析构时再 close
+    shutdown(fd_, SHUT_RDWR);
+    HandleClose();
+}
+
+void Connection::Shutdown() {
+    loop_->RunInLoop([self = shared_from_this()] {
+        if (self->closed_) return;
+        self->Write();
+        IM_DEBUG("fd %d shutdown (%zu bytes pending)", self->fd_,
+                 self->output_queue_.PendingBytes());
+        self->output_queue_.Clear();
+        self->SyncOutputBudget();
+        // 只关写：已经交给内核的数据发完再发 FIN
+        shutdown(self->fd_, SHUT_WR);
+        self->handed_over_ = true;
+        self->HandleClose();
+    });
+}
+
+void Connection::ForceClose(const char *reason) {
+    IM_WARN("fd %d %s (%zu bytes pending), closing.", fd_, reason,
+            output_queue_.PendingBytes());
+    FlowControl::GetInstance().CountDisconnect();
+    output_queue_.Clear();
+    SyncOutputBudget();
+    shutdown(fd_, SHUT_RDWR);
+    HandleClose();
+}
+
+void Connection::HandleClose() {
+    if (closed_) return;
+    closed_ = true;
+    // 下线清理排在本连接已收到的业务任务之后：还没跑完的登录
+    // 不会在清理之后才把用户注册回在线表；写Redis也不再阻塞IO线程
+    strand_->Post(ThreadPool::GetInstance(), [self = shared_from_this()] {
+        const std::string &user = self->current_user_;
+        if (user.empty()) return;
+        // 在线用户本删除
+        UserManager::GetInstance().RemoveUser(user);
+        IM_INFO("User '%s' removed from UserManager.", user.c_str());
+        // 平滑重启关掉的连接会马上重连到新进程，在线状态归新进程管，
+        // 这里再删可能把新进程刚写的在线状态删掉
+        if (self->handed_over_) return;
+        // 从redis 删除状态
+        RedisManager::GetInstance().SetUserOffline(user);
+        IM_INFO("User '%s' status synced to Redis (offline).", user.c_str());
+    });
+    if (close_callback_) {
+        close_callback_(fd_);
+    }
 }
 
 void Connection::Read() {
-    char buf[1024];
-    while (true) {  // 非阻塞必须循环度，直到无法读取数据为止
-        int bytes_read = read(fd_, buf, sizeof(buf));
+    size_t total_read = 0;
+    // 非阻塞需要读到EAGAIN；但单次唤醒最多读 kMaxReadPerWakeup，
+    // 剩下的交给水平触发的下一轮，避免一个大流量连接饿死同loop的其他连接
+    bool drained = false;
+    while (total_read < kMaxReadPerWakeup) {
+        // 一次readv同时填buffer空闲区和64KB栈上扩展区
+        int saved_errno = 0;
+        size_t writable = read_buffer_.WritableBytes();
+        ssize_t bytes_read = read_buffer_.ReadFd(fd_, &saved_errno);
+        errno = saved_errno;
         if (bytes_read > 0) {
-            read_buffer_.Append(buf, bytes_read);
+            total_read += bytes_read;
+            // 没读满说明内核缓冲区已经空了，省掉一次注定EAGAIN的read
+            if (static_cast<size_t>(bytes_read) <
+                writable + Buffer::kExtraBufSize) {
+                drained = true;
+                break;
+            }
         } else if (bytes_read == -1 && errno == EINTR) {
             // 被系统信息打断，正常情况继续读
             continue;
         } else if (bytes_read == -1 &&
                    (errno == EAGAIN || errno == EWOULDBLOCK)) {
             // EAGAIN说明当前缓冲区已经读取完，需要等下次epoll通知
+            drained = true;
             break;
         } else if (bytes_read == 0) {
             // 代表客户端主动断开了连接
-            spdlog::info("client disconnected,fd:{}", fd_);
-            if (!current_user_.empty()) {
-                // 在线用户本删除
-                UserManager::GetInstance().RemoveUser(current_user_);
-                spdlog::info("User '{}' removed from UserManager.",
-                             current_user_);
-                // 从redis 删除状态
-                RedisManager::GetInstance().SetUserOffline(current_user_);
-                spdlog::info("User '{}' status synced to Redis (offline).",
-                             current_user_);
-            }
-            if (close_callback_) {
-                close_callback_(fd_);
-            }
+            IM_DEBUG("client disconnected,fd:%d", fd_);
+            HandleClose();
             return;
         } else {
-            std::cerr << "Read error on fd: " << fd_ << std::endl;
-            if (close_callback_) close_callback_(fd_);
+            IM_WARN("Read error on fd %d: %s", fd_, strerror(errno));
+            HandleClose();
             return;
         }
     }
+    loop_->RecordRead(total_read);
+    // 内核处理完一段数据就会退回延迟确认，每次读完重新打开
+    if (quick_ack_ && total_read > 0) RearmQuickAck(fd_);
+
+    ProcessFrames();
+    // 边缘触发读到上限还没读空的，内核不会再报，排到本轮末尾接着读
+    if (!drained && EdgeTriggered()) {
+        loop_->QueueInLoop([self = shared_from_this()] {
+            if (!self->closed_ && !self->read_paused_) self->Read();
+        });
+    }
+}
 
-    while (true) {
-        uint32_t msg_type = 0;
-        std::string msg_body = "";
-        bool success = Codec::ParseMessage(&read_buffer_, msg_type, msg_body);
-        if (!success) {
-            // 解析失败
+void Connection::ProcessFrames() {
+    // 内联处理的命令可能在发送失败时关掉连接，关了就不再往下拆；
+    // 因为积压暂停读以后也不再拆，剩下的包等恢复时接着处理
+    size_t frames = 0;
+    while (!closed_ && !read_paused_) {
+        Codec::Frame frame;
+        if (!Codec::PeekFrame(&read_buffer_, frame)) {
+            // 半包，等下次数据
             break;
         }
-        std::cout << "[Codec] 成功拆出一个完整包！Type: " << msg_type
-                  << ", Body: " << msg_body << std::endl;
+        ++frames;
+        IM_TRACE("[Codec] fd %d frame type %u, body %.*s", fd_,
+                 frame.msg_type, static_cast<int>(frame.body.size()),
+                 frame.body.data());
         this->UpdateActiveTime();
-        if (msg_type == 3) {
-            // 3 代表ping
-            spdlog::debug("Received Ping from fd: {}", fd_);
-            // 立即回一个type =4（pong）
-            std::string pong_json = "{\"msg\":\"pong\"}";
-            std::string pong_packet = Codec::PackMessage(4, pong_json);
-            Send(pong_packet);
+        if (frame.flags & Codec::kCompressed) {
+            // 压缩包先在本线程解开，分发时和普通包一样
+            std::string inflated;
+            if (!Compressor::GetInstance().Decompress(frame.body, inflated)) {
+                IM_WARN("Bad compressed frame on fd %d, closing.", fd_);
+                shutdown(fd_, SHUT_RDWR);
+                HandleClose();
+                break;
+            }
+            Codec::Frame plain = frame;
+            plain.flags &= ~Codec::kCompressed;
+            plain.body = inflated;
+            MessageDispatcher::GetInstance().Dispatch(shared_from_this(), plain);
+            Codec::RetrieveFrame(&read_buffer_, frame);
             continue;
         }
-        ThreadPool::GetInstance().Enqueue([self = shared_from_this(), msg_type,
-                                           msg_body] {
-            try {
-                // json 反序列化
-                json req_json = json::parse(msg_body);
-                // 构造回包 json
-                json resp_json;
-                // ======== 业务路由分发 ==========
-                if (msg_type == 1) {  // 登录请求
-                    std::string cmd = req_json.value("cmd", "");
-                    if (cmd == "login") {
-                        std::string username = req_json.value("username", "");
-                        std::string password = req_json.value("password", "");
+        // 按类型查表：便宜的命令就在本线程处理，其余拷贝包体后投递到线程池。
+        // 内联处理时 body 还指向读缓冲区，所以先分发再取走
+        MessageDispatcher::GetInstance().Dispatch(shared_from_this(), frame);
+        Codec::RetrieveFrame(&read_buffer_, frame);
+    }
+    loop_->RecordFrames(frames);
+}
+
+void Connection::Send(std::string msg) {
+    Send(std::make_shared<const std::string>(std::move(msg)));
+}
 
-                        bool is_valid = MySQLManager::GetInstance().CheckUser(
-                            username, password);
-                        resp_json["cmd"] = "login_resp";
-                        if (is_valid) {
-                            resp_json["code"] = 200;
-                            resp_json["msg"] = "Login Success!";
-                            self->current_user_ = username;
-                            UserManager::GetInstance().AddUser(username, self);
-                            spdlog::info(
-                                "User '{}' login and registered in "
-                                "UserManager.",
-                                username);
-                            // 将状态写入redis
-                            RedisManager::GetInstance().SetUserOnline(username);
-                            spdlog::info(
-                                "User '{}' status synced to Redis (Online).",
-                                username);
-                            std::string response_packet =
-                                Codec::PackMessage(msg_type, resp_json.dump());
-                            self->Send(response_packet);
-                            // 获取离线消息
-                            auto offline_msgs =
-                                MySQLManager::GetInstance()
-                                    .GetAndClearOfflineMessages(username);
-                            if (!offline_msgs.empty()) {
-                                spdlog::info(
-                                    "pushing {} offline message to user '{}'",
-                                    offline_msgs.size(), username);
-                                for (const auto &msg_str : offline_msgs) {
-                                    std::string push_packet =
-                                        Codec::PackMessage(2, msg_str);
-                                    self->Send(push_packet);
-                                }
-                            }
-                            return;
-                        } else {
-                            resp_json["code"] = 401;
-                            resp_json["msg"] = "Invalid username or password";
-                        }
-                        std::string response_packet =
-                            Codec::PackMessage(msg_type, resp_json.dump());
-                        self->Send(response_packet);
-                    }
-                } else if (msg_type == 2) {  // 单聊
-                    std::string cmd = req_json.value("cmd", "");
-                    if (cmd == "chat") {
-                        std::string target_user = req_json.value("to", "");
-                        std::string content = req_json.value("msg", "");
-                        spdlog::info("Route msg from '{}' to '{}'",
-                                     self->current_user_, target_user);
-                        auto target_conn_ptr = UserManager::GetInstance()
-                                                   .GetConnection(target_user)
-                                                   .lock();  // 尝试获取
-                        if (target_conn_ptr != nullptr) {    // 目标在线
-                            json push_json;
-                            push_json["cmd"] = "push_chat";
-                            push_json["from"] = self->current_user_;
-                            push_json["msg"] = content;
-                            std::string push_packet =
-                                Codec::PackMessage(2, push_json.dump());
-                            // 跨对象调用
-                            target_conn_ptr->Send(push_packet);
-                            resp_json["code"] = 200;
-                            resp_json["msg"] =
-                                "Message forwarded successfully.";
-                        } else {
-                            // 目标不在线
-                            spdlog::info(
-                                "User '{}' if offline. Saving message to "
-                                "database",
-                                target_user);
-                            bool saved =
-                                MySQLManager::GetInstance()
-                                    .InsertOfflineMessage(self->current_user_,
-                                                          target_user, content);
-                            if (saved) {  // 用户离线，存放数据库
-                                resp_json["code"] = 200;
-                                resp_json["msg"] =
-                                    "User offline. Message save to server "
-                                    "successfully.";
-                            } else {  // 数据库挂了
-                                resp_json["code"] = 500;
-                                resp_json["msg"] =
-                                    "Internal server erro.Failed to save "
-                                    "message";
-                            }
-                        }
-                    } else if (cmd == "group_chat") {  // 群聊
-                        int group_id = req_json["group_id"];
-                        std::string content = req_json["msg"];
-                        // 1、验证：发送者自己必须在群里
-                        if (!GroupManager::GetInstance().IsUserInGroup(
-                                group_id, self->current_user_)) {
-                            resp_json["code"] = 403;
-                            resp_json["msg"] =
-                                "Permission denied.You are not in the group";
-                            self->Send(
-                                Codec::PackMessage(msg_type, resp_json.dump()));
-                            return;
-                        }
-                        // 2、拿到群名单开始暴力裂变
-                        auto members =
-                            GroupManager::GetInstance().GetGroupMembers(
-                                group_id);
-                        int online_count = 0;
-                        int offline_count = 0;
-                        for (const auto &member : members) {
-                            if (member == self->current_user_) continue;
-                            json push_json;
-                            push_json["cmd"] = "push_group_chat";
-                            push_json["group_id"] = group_id;
-                            push_json["from"] = self->current_user_;
-                            push_json["msg"] = content;
-                            std::string push_packet =
-                                Codec::PackMessage(2, push_json.dump());
-                            // 3. 核心路由分支：去户口本查人
-                            std::weak_ptr<Connection> target_conn =
-                                UserManager::GetInstance().GetConnection(
-                                    member);
-                            if (auto target_conn_ptr =
-                                    UserManager::GetInstance()
-                                        .GetConnection(member)
-                                        .lock()) {
-                                target_conn_ptr->Send(push_packet);
-                                online_count++;
-                            } else {
-                                MySQLManager::GetInstance()
-                                    .InsertOfflineMessage(self->current_user_,
-                                                          member,
-                                                          "[群聊] " + content);
-                                offline_count++;
-                            }
-                        }
-                        // 4. 给发送者回执
-                        resp_json["code"] = 200;
-                        resp_json["msg"] =
-                            "Group message sent! Online: " +
-                            std::to_string(online_count) +
-                            ", Offline saved: " + std::to_string(offline_count);
-                        self->Send(
-                            Codec::PackMessage(msg_type, resp_json.dump()));
-                        return;
-                    }
-                    // 给发送者回执包
-                    std::string response_packet =
-                        Codec::PackMessage(msg_type, resp_json.dump());
-                    self->Send(response_packet);
+void Connection::Send(PacketPtr packet) {
+    if (loop_->IsInLoopThread()) {
+        SendInLoop(std::move(packet));
+        return;
+    }
+    // 业务线程发来的消息，无锁投递给连接所属的loop线程，攒批后统一写
+    loop_->QueueInLoop([self = shared_from_this(), packet = std::move(packet)] {
+        self->SendInLoop(packet);
+    });
+}
+
+void Connection::Broadcast(
+    const std::vector<std::shared_ptr<Connection>> &conns,
+    const PacketPtr &packet) {
+    static Histogram *fanout = MetricsRegistry::GetInstance().GetHistogram(
+        "im_fanout_size", "Number of target connections per broadcast");
+    fanout->Record(conns.size());
+    // 按所属loop分组，每个loop只投递一次任务，在loop线程里逐个入队
+    std::unordered_map<EventLoop *, std::vector<std::shared_ptr<Connection>>>
+        by_loop;
+    for (const auto &conn : conns) {
+        by_loop[conn->loop_].push_back(conn);
+    }
+    for (auto &entry : by_loop) {
+        entry.first->RunInLoop(
+            [packet, targets = std::move(entry.second)] {
+                for (const auto &conn : targets) {
+                    conn->SendInLoop(packet, true);
                 }
-            } catch (json::parse_error &e) {
-                spdlog::error("JSON parsing error on fd {}:{}", self->fd_,
-                              e.what());
+            });
+    }
+}
+
+void Connection::SendInLoop(PacketPtr packet, bool droppable) {
+    if (closed_) return;
+    output_queue_.Push(std::move(packet), droppable);
+    SyncOutputBudget();
+    CheckHighWater();
+    if (closed_) return;
+    // 正在等可写的话可写时自然会写；否则等本轮事件和任务都处理完
+    // 再flush，同一轮里的回包、推送（比如登录回包+一串离线消息）合并成一次 sendmsg
+    if (!write_blocked_) loop_->MarkDirty(&channel_);
+}
+
+void Connection::Flush() {
+    if (!closed_) Write();
+}
+
+void Connection::SyncOutputBudget() {
+    size_t pending = output_queue_.PendingBytes();
+    if (pending == budgeted_bytes_) return;
+    FlowControl::GetInstance().Adjust(static_cast<int64_t>(pending) -
+                                      static_cast<int64_t>(budgeted_bytes_));
+    budgeted_bytes_ = pending;
+}
+
+void Connection::CheckHighWater() {
+    FlowControl &flow = FlowControl::GetInstance();
+    size_t pending = output_queue_.PendingBytes();
+    if (pending <= flow.LowWater()) return;
+    bool over_high = pending > flow.HighWater();
+    // 全局预算超了：过了低水位的连接都按超高水位处理，积压多的先被处理
+    if (!over_high) {
+        if (!flow.OverBudget()) return;
+        flow.CountBudgetHit();
+    }
+    switch (flow.Policy()) {
+        case SlowConsumerPolicy::kDisconnect:
+            ForceClose("slow consumer over high water");
+            return;
+        case SlowConsumerPolicy::kDropOldest: {
+            size_t packets = 0;
+            size_t bytes = output_queue_.DropOldest(flow.LowWater(), &packets);
+            if (packets > 0) {
+                flow.CountDrop(packets, bytes);
+                SyncOutputBudget();
             }
-        });
+            break;
+        }
+        case SlowConsumerPolicy::kPauseRead:
+            // 先不再读它的请求，它自己的回包就不会继续涨
+            if (!read_paused_ && channel_.IsReading()) {
+                read_paused_ = true;
+                channel_.DisableReading();
+                flow.CountPause();
+                IM_DEBUG("fd %d output %zu bytes over high water, pause read",
+                         fd_, pending);
+            }
+            break;
+    }
+    // 别人推给它的（单聊、回包）丢不掉也停不住，到硬上限就断开
+    if (output_queue_.PendingBytes() > flow.HardLimit()) {
+        ForceClose("slow consumer over hard limit");
     }
 }
 
-void Connection::Send(const std::string &msg) {
-    std::lock_guard<std::mutex> lock(send_mutex_);
-    bool was_empty = write_buffer_.empty();
-    write_buffer_.append(msg);
-    if (was_empty) {
-        loop_->AddEvent(fd_, EPOLLIN | EPOLLOUT, [this](uint32_t revents) {
-            this->HandleEvent(revents);
-        });
+void Connection::CheckLowWater() {
+    if (!read_paused_ ||
+        output_queue_.PendingBytes() > FlowControl::GetInstance().LowWater()) {
+        return;
     }
-    // 简化板，先用write，一次发不完，应该存入write_buffer_
-    write(fd_, msg.c_str(), msg.length());
+    read_paused_ = false;
+    channel_.EnableReading();
+    FlowControl::GetInstance().CountResume();
+    IM_DEBUG("fd %d output drained, resume read", fd_);
+    // 暂停前已经读进缓冲区的包接着处理
+    ProcessFrames();
 }
 
 void Connection::HandleEvent(uint32_t revents) {
     auto guard = shared_from_this();
+    // 出错直接关。挂断时还有可读数据的照常读，读到 0 再关，不丢对端最后的包；
+    // 暂停读的连接没关注 EPOLLIN，挂断只能在这里处理，否则水平触发会一直报
+    if ((revents & EPOLLERR) ||
+        ((revents & EPOLLHUP) && !(revents & EPOLLIN))) {
+        IM_DEBUG("fd %d hangup/error (events 0x%x), closing", fd_, revents);
+        HandleClose();
+        return;
+    }
     if (revents & EPOLLIN) {
         Read();
     }
-    if (revents & EPOLLOUT) {
+    if ((revents & EPOLLOUT) && !closed_) {
         Write();
     }
 }
 
 void Connection::Write() {
-    std::lock_guard<std::mutex> lock(send_mutex_);
-    if (write_buffer_.empty()) return;
-    int bytes_wrote = write(fd_, write_buffer_.data(), write_buffer_.length());
-    if (bytes_wrote > 0) {  // 剔除已经成功发出的数据
-        write_buffer_.erase(0, bytes_wrote);
-    } else if (bytes_wrote == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
-        // 内核缓冲区满了，写不进去了，需要下次EPOLLOUT唤醒
-        return;
-    } else {
-        spdlog::error("Write error on fd:{}", fd_);
-        if (close_callback_) close_callback_(fd_);
-        return;
+    if (!output_queue_.Empty()) {
+        WriteStats stats;
+        ssize_t bytes_wrote = output_queue_.WriteTo(fd_, cork_mode_, &stats);
+        loop_->RecordWrite(stats.calls, stats.packets,
+                           bytes_wrote > 0 ? bytes_wrote : 0);
+        // 先写出一部分再出错的也算，不用等下一次 EPOLLOUT 才发现
+        if (stats.error != 0) {
+            IM_ERROR("Write error on fd %d: %s", fd_, strerror(stats.error));
+            output_queue_.Clear();
+            SyncOutputBudget();
+            HandleClose();
+            return;
+        }
+        SyncOutputBudget();
     }
-    // 数据发送完了，需要取消EPOLLOUT监听，仅保留EPOLLIN
-    if (write_buffer_.empty()) {
-        loop_->AddEvent(fd_, EPOLLIN, [this](uint32_t revents) {
-            this->HandleEvent(revents);
-        });
+    write_blocked_ = !output_queue_.Empty();
+    // 还有数据没写完才关注EPOLLOUT，写空了就取消，避免空转；
+    // 边缘触发一直关注着，缓冲区腾出空间时报一次，不用改注册
+    if (!EdgeTriggered() && write_blocked_ != channel_.IsWriting()) {
+        if (write_blocked_) {
+            channel_.EnableWriting();
+        } else {
+            channel_.DisableWriting();
+        }
     }
-}
\ No newline at end of file
+    CheckLowWater();
+}
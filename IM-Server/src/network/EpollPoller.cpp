@@ -0,0 +1,58 @@
+#include "network/EpollPoller.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "common/Logging.h"
+#include "network/Channel.h"
+
+EpollPoller::EpollPoller() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1) throw std::runtime_error("epoll create failed");
+}
+
+EpollPoller::~EpollPoller() { close(epoll_fd_); }
+
+int EpollPoller::Poll(int timeout_ms, std::vector<Event> &active) {
+    int nfds = epoll_wait(epoll_fd_, events_, MAX_EVENTS, timeout_ms);
+    if (nfds == -1) return -1;
+    for (int i = 0; i < nfds; ++i) {
+        // data.ptr 就是注册时的Channel。Channel 的销毁都延后到
+        // DoPendingFunctors，本批事件里的指针一定有效
+        Channel *channel = static_cast<Channel *>(events_[i].data.ptr);
+        if (channel->Mode() == TriggerMode::kOneShot) channel->SetArmed(false);
+        active.push_back({channel, events_[i].events});
+    }
+    return nfds;
+}
+
+void EpollPoller::UpdateChannel(Channel *channel) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.data.ptr = channel;
+    ev.events = channel->Events();
+    if (channel->Mode() == TriggerMode::kEdge) ev.events |= EPOLLET;
+    if (channel->Mode() == TriggerMode::kOneShot) ev.events |= EPOLLONESHOT;
+    // Channel 记住自己是否已注册，ADD/MOD 只需一次系统调用
+    int op = channel->IsAdded() ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    ++ctl_calls_;
+    if (epoll_ctl(epoll_fd_, op, channel->Fd(), &ev) == -1) {
+        IM_ERROR("epoll_ctl %s failed on fd %d: %s",
+                 op == EPOLL_CTL_ADD ? "add" : "mod", channel->Fd(),
+                 strerror(errno));
+        return;
+    }
+    channel->SetAdded(true);
+    // MOD 同时会重新挂上单次触发的fd
+    channel->SetArmed(true);
+}
+
+void EpollPoller::RemoveChannel(Channel *channel) {
+    if (!channel->IsAdded()) return;
+    ++ctl_calls_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, channel->Fd(), nullptr);
+    channel->SetAdded(false);
+}
@@ -1,53 +1,289 @@
 #include "network/EventLoop.h"
 
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
 #include <stdexcept>
 
-EventLoop::EventLoop() : quit_(false) {
-    epoll_fd_ = epoll_create1(0);
-    if (epoll_fd_ == -1) throw std::runtime_error("epoll create failed");
+#include "common/CoarseClock.h"
+#include "common/Logging.h"
+
+// 发送统计日志间隔
+static const uint64_t kIoStatsIntervalMs = 60 * 1000;
+
+static int64_t MonotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+EventLoop::EventLoop(const std::string &poller)
+    : poller_(Poller::Create(poller)),
+      quit_(false),
+      thread_id_(std::this_thread::get_id()),
+      wakeup_pending_(false),
+      connection_count_(0) {
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ == -1) throw std::runtime_error("eventfd create failed");
+    wakeup_channel_.reset(new Channel(this, wakeup_fd_));
+    wakeup_channel_->SetEventCallback(
+        [this](uint32_t) { this->HandleWakeup(); });
+    wakeup_channel_->EnableReading();
+
+    // 时间轮由周期性 timerfd 驱动
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ == -1) {
+        close(wakeup_fd_);
+        throw std::runtime_error("timerfd create failed");
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = kTickMs / 1000;
+    spec.it_interval.tv_nsec = (kTickMs % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timer_fd_, 0, &spec, nullptr);
+    timer_channel_.reset(new Channel(this, timer_fd_));
+    timer_channel_->SetEventCallback(
+        [this](uint32_t) { this->HandleTimer(); });
+    timer_channel_->EnableReading();
 }
 EventLoop::~EventLoop() {
-    if (epoll_fd_ != -1) {
-        close(epoll_fd_);
+    wakeup_channel_->Remove();
+    timer_channel_->Remove();
+    if (timer_fd_ != -1) {
+        close(timer_fd_);
+    }
+    if (wakeup_fd_ != -1) {
+        close(wakeup_fd_);
     }
 }
 
-void EventLoop::AddEvent(int fd, uint32_t events, EventCallback cb) {
-    struct epoll_event ev{0};
-    ev.data.fd = fd;
-    ev.events = events;
-    // 简化处理，一般需要进行判断
-    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
-        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+void EventLoop::UpdateChannel(Channel *channel) {
+    poller_->UpdateChannel(channel);
+}
+
+void EventLoop::RemoveChannel(Channel *channel) {
+    if (channel->IsDirty()) {
+        // 马上要析构了，从待flush列表里摘掉（正在flush的那一批里置空）
+        channel->SetDirty(false);
+        for (auto *list : {&dirty_channels_, &flushing_}) {
+            for (Channel *&entry : *list) {
+                if (entry == channel) entry = nullptr;
+            }
+        }
     }
-    // 绑定业务逻辑
-    callbacks_[fd] = cb;
+    poller_->RemoveChannel(channel);
+}
+
+void EventLoop::MarkDirty(Channel *channel) {
+    if (channel->IsDirty()) return;
+    channel->SetDirty(true);
+    dirty_channels_.push_back(channel);
+}
+
+void EventLoop::FlushDirty() {
+    // flush 里一般不会再产生新的待发数据，万一有，下一轮接着处理
+    while (!dirty_channels_.empty()) {
+        flushing_.swap(dirty_channels_);
+        for (Channel *channel : flushing_) {
+            if (channel == nullptr) continue;
+            channel->SetDirty(false);
+            channel->HandleFlush();
+        }
+        flushing_.clear();
+    }
+}
+
+// loop线程是唯一的写者，不需要 fetch_add
+static void AddRelaxed(std::atomic<uint64_t> &counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
+
+void EventLoop::RecordWrite(size_t calls, size_t packets, size_t bytes) {
+    AddRelaxed(io_stats_.flushes, 1);
+    AddRelaxed(io_stats_.write_calls, calls);
+    AddRelaxed(io_stats_.packets, packets);
+    AddRelaxed(io_stats_.bytes, bytes);
+}
+
+void EventLoop::RecordFrames(size_t frames) {
+    AddRelaxed(io_stats_.frames, frames);
+}
+
+void EventLoop::RecordRead(size_t bytes) {
+    AddRelaxed(io_stats_.bytes_in, bytes);
+}
+
+void EventLoop::ReportIoStats() {
+    uint64_t calls = io_stats_.write_calls.load(std::memory_order_relaxed);
+    uint64_t packets = io_stats_.packets.load(std::memory_order_relaxed);
+    uint64_t frames = io_stats_.frames.load(std::memory_order_relaxed);
+    uint64_t polls = io_stats_.polls.load(std::memory_order_relaxed);
+    uint64_t wakeups = io_stats_.wakeups.load(std::memory_order_relaxed);
+    uint64_t ctl_calls = io_stats_.ctl_calls.load(std::memory_order_relaxed);
+    uint64_t busy_polls = io_stats_.busy_polls.load(std::memory_order_relaxed);
+    // 只有定时器在走的空闲loop不打
+    if (calls == reported_calls_ && frames == reported_frames_) return;
+    uint64_t delta_calls = calls - reported_calls_;
+    uint64_t delta_packets = packets - reported_packets_;
+    uint64_t delta_frames = frames - reported_frames_;
+    uint64_t delta_ctl = ctl_calls - reported_ctl_calls_;
+    IM_INFO("[io] loop %p (%s): %llu sendmsg for %llu packets "
+            "(%.2f packets/call), %llu frames in, %llu polls, %llu wakeups, "
+            "%llu ctl (%.3f ctl/frame), %llu empty busy polls",
+            static_cast<void *>(this), poller_->Name(),
+            static_cast<unsigned long long>(delta_calls),
+            static_cast<unsigned long long>(delta_packets),
+            delta_calls > 0 ? static_cast<double>(delta_packets) / delta_calls
+                            : 0.0,
+            static_cast<unsigned long long>(delta_frames),
+            static_cast<unsigned long long>(polls - reported_polls_),
+            static_cast<unsigned long long>(wakeups - reported_wakeups_),
+            static_cast<unsigned long long>(delta_ctl),
+            delta_frames > 0 ? static_cast<double>(delta_ctl) / delta_frames
+                             : 0.0,
+            static_cast<unsigned long long>(busy_polls - reported_busy_polls_));
+    reported_calls_ = calls;
+    reported_packets_ = packets;
+    reported_frames_ = frames;
+    reported_polls_ = polls;
+    reported_wakeups_ = wakeups;
+    reported_ctl_calls_ = ctl_calls;
+    reported_busy_polls_ = busy_polls;
 }
 
-void EventLoop::RemoveEvent(int fd) {
-    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
-    callbacks_.erase(fd);  // 清理回调
+void EventLoop::Quit() {
+    quit_ = true;
+    if (!IsInLoopThread()) Wakeup();
+}
+
+void EventLoop::RunInLoop(Functor cb) {
+    if (IsInLoopThread()) {
+        cb();
+    } else {
+        QueueInLoop(std::move(cb));
+    }
+}
+
+void EventLoop::QueueInLoop(Functor cb) {
+    pending_functors_.Push(std::move(cb));
+    // loop线程自己投递的任务（包括 flush 期间投递的）本轮 poll 之前一定会执行，
+    // 不用唤醒；
+    // 其他线程投递时，只有第一个把标志从 false 翻成 true 的人写 eventfd
+    if (!IsInLoopThread() &&
+        !wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+        Wakeup();
+    }
+}
+
+void EventLoop::Wakeup() {
+    io_stats_.wakeups.fetch_add(1, std::memory_order_relaxed);
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd_, &one, sizeof(one));
+    if (n != sizeof(one)) {
+        IM_ERROR("EventLoop wakeup write %zd bytes", n);
+    }
+}
+
+void EventLoop::HandleWakeup() {
+    uint64_t one = 0;
+    ssize_t n = read(wakeup_fd_, &one, sizeof(one));
+    if (n != sizeof(one)) {
+        IM_ERROR("EventLoop wakeup read %zd bytes", n);
+    }
+}
+
+void EventLoop::HandleTimer() {
+    uint64_t expirations = 0;
+    ssize_t n = read(timer_fd_, &expirations, sizeof(expirations));
+    if (n != sizeof(expirations)) return;
+    CoarseClock::Update();
+    // loop 被阻塞过的话一次补上错过的tick
+    timer_wheel_.Advance(expirations);
+    stats_ticks_ += expirations;
+    if (stats_ticks_ * kTickMs >= kIoStatsIntervalMs) {
+        stats_ticks_ = 0;
+        ReportIoStats();
+    }
+}
+
+void EventLoop::DoPendingFunctors() {
+    // 先清标志再取任务：清完之后入队的生产者会重新唤醒，不会漏；
+    // 用 exchange 而不是 store，才能看到清标志之前的生产者入队的内容
+    wakeup_pending_.exchange(false, std::memory_order_acq_rel);
+    // 一直取到空，任务里再投递的（例如攒批后的发送flush）也在本轮执行
+    Functor functor;
+    while (pending_functors_.Pop(functor)) {
+        functor();
+    }
+}
+
+// 窗口从这么大开始放大，缩到比它小就当作 0
+static const int kMinSpinUs = 10;
+
+void EventLoop::AdaptBusyPoll(int timeout_ms, int busy_poll_us) {
+    if (active_events_.empty()) {
+        if (timeout_ms == 0) AddRelaxed(io_stats_.busy_polls, 1);
+        return;
+    }
+    int64_t now = MonotonicUs();
+    // 转着接住的事件不用调整；阻塞之后等到的，看离上一次事件隔了多久
+    if (timeout_ms != 0) {
+        if (now - last_active_us_ <= busy_poll_us) {
+            spin_window_us_ = std::min(
+                busy_poll_us, std::max(spin_window_us_ * 2, kMinSpinUs));
+        } else {
+            spin_window_us_ /= 2;
+            if (spin_window_us_ < kMinSpinUs) spin_window_us_ = 0;
+        }
+    }
+    last_active_us_ = now;
 }
 
 void EventLoop::Loop() {
     while (!quit_) {
         // 2、等待事件发生
-        int nfds = epoll_wait(epoll_fd_, events_, MAX_EVENTS, -1);
-        if (nfds == -1) {
+        active_events_.clear();
+        int busy_poll_us = busy_poll_us_.load(std::memory_order_relaxed);
+        int timeout_ms = -1;
+        if (busy_poll_us > 0 &&
+            MonotonicUs() - last_active_us_ <
+                std::min(spin_window_us_, busy_poll_us)) {
+            timeout_ms = 0;
+        }
+        if (poller_->Poll(timeout_ms, active_events_) == -1) {
             if (errno == EINTR) continue;
+            IM_ERROR("%s poll failed: %s", poller_->Name(), strerror(errno));
             break;
         }
-        for (int i = 0; i < nfds; ++i) {
-            int fd = events_[i].data.fd;
-            uint32_t revents = events_[i].events;
-            // 这是处理逻辑的分发点
-            std::cout << "Event triggered on fd: " << fd << std::endl;
-            if (callbacks_.count(fd)) {
-                callbacks_[fd](revents);
+        AddRelaxed(io_stats_.polls, 1);
+        if (busy_poll_us > 0) AdaptBusyPoll(timeout_ms, busy_poll_us);
+        for (const Poller::Event &event : active_events_) {
+            // 这是处理逻辑的分发点。
+            // Channel 的销毁都延后到 DoPendingFunctors，本批事件里的指针一定有效
+            Channel *channel = event.channel;
+            IM_TRACE("Event 0x%x triggered on fd %d", event.revents,
+                     channel->Fd());
+            channel->HandleEvent(event.revents);
+            // 单次触发的fd：回调里改过注册就已经顺带挂上了，没改过才补一次
+            if (!channel->IsArmed() && channel->IsAdded() &&
+                channel->Events() != 0) {
+                poller_->UpdateChannel(channel);
             }
         }
+        // 3、处理投递过来的任务；4、本轮攒下的发送，每个连接写一次。
+        // flush 里写出错关掉的连接会再投递 ConnectDestroyed，
+        // 所以两边来回处理到都空为止，不能拖到下一次 poll 返回
+        do {
+            DoPendingFunctors();
+            FlushDirty();
+        } while (!pending_functors_.Empty());
+        io_stats_.ctl_calls.store(poller_->CtlCalls(),
+                                  std::memory_order_relaxed);
     }
-}
\ No newline at end of file
+}
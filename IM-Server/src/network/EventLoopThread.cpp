@@ -0,0 +1,46 @@
+#include "network/EventLoopThread.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "common/Logging.h"
+
+EventLoopThread::~EventLoopThread() {
+    {
+        // 加锁读loop_，避免线程正在退出时loop已析构
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loop_ != nullptr) loop_->Quit();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+EventLoop *EventLoopThread::StartLoop(int cpu) {
+    thread_ = std::thread([this, cpu] { this->ThreadFunc(cpu); });
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return loop_ != nullptr; });
+    return loop_;
+}
+
+void EventLoopThread::ThreadFunc(int cpu) {
+    if (cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) !=
+            0) {
+            IM_WARN("Pin loop thread to cpu %d failed.", cpu);
+        }
+    }
+    // loop必须在自己的线程里构造，thread_id_才是对的
+    EventLoop loop(poller_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loop_ = &loop;
+    }
+    cond_.notify_one();
+    loop.Loop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = nullptr;
+}
@@ -0,0 +1,29 @@
+#include "network/EventLoopThreadPool.h"
+
+#include "common/Logging.h"
+
+EventLoopThreadPool::EventLoopThreadPool(EventLoop *base_loop,
+                                         size_t num_threads,
+                                         const std::string &policy,
+                                         const std::string &poller)
+    : base_loop_(base_loop),
+      num_threads_(num_threads),
+      poller_(poller),
+      balancer_(LoadBalancer::Create(policy)) {}
+
+void EventLoopThreadPool::Start(bool pin_cpu) {
+    unsigned num_cpus = std::thread::hardware_concurrency();
+    for (size_t i = 0; i < num_threads_; ++i) {
+        int cpu =
+            (pin_cpu && num_cpus > 0) ? static_cast<int>(i % num_cpus) : -1;
+        threads_.emplace_back(new EventLoopThread(poller_));
+        loops_.push_back(threads_.back()->StartLoop(cpu));
+    }
+    IM_INFO("EventLoopThreadPool started with %zu sub loops (%s).",
+            num_threads_, poller_.c_str());
+}
+
+EventLoop *EventLoopThreadPool::GetNextLoop() {
+    if (loops_.empty()) return base_loop_;
+    return balancer_->Select(loops_);
+}
@@ -0,0 +1,71 @@
+#include "network/FlowControl.h"
+
+#include "common/CoarseClock.h"
+#include "common/Logging.h"
+
+static const time_t kReportInterval = 10;
+
+FlowControl &FlowControl::GetInstance() {
+    static FlowControl instance;
+    return instance;
+}
+
+void FlowControl::Init(const FlowControlOptions &options) {
+    if (options.policy == "pause_read") {
+        policy_ = SlowConsumerPolicy::kPauseRead;
+    } else if (options.policy == "disconnect") {
+        policy_ = SlowConsumerPolicy::kDisconnect;
+    } else {
+        policy_ = SlowConsumerPolicy::kDropOldest;
+    }
+    high_water_ = options.high_water;
+    // 低水位必须在高水位之下，否则恢复读和丢包都会来回抖
+    low_water_ = options.low_water < high_water_ ? options.low_water
+                                                 : high_water_ / 2;
+    hard_limit_ = options.hard_limit > high_water_ ? options.hard_limit
+                                                   : high_water_;
+    global_budget_ = options.global_budget;
+    IM_INFO("flow control: policy %s, water %zu/%zu, hard limit %zu, "
+            "global budget %zu",
+            options.policy.c_str(), low_water_, high_water_, hard_limit_,
+            global_budget_);
+}
+
+void FlowControl::CountDrop(size_t packets, size_t bytes) {
+    dropped_packets_.fetch_add(packets, std::memory_order_relaxed);
+    dropped_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    MaybeReport();
+}
+
+FlowControl::Stats FlowControl::GetStats() const {
+    Stats stats;
+    stats.outstanding = outstanding_.load(std::memory_order_relaxed);
+    stats.paused = paused_.load(std::memory_order_relaxed);
+    stats.resumed = resumed_.load(std::memory_order_relaxed);
+    stats.dropped_packets = dropped_packets_.load(std::memory_order_relaxed);
+    stats.dropped_bytes = dropped_bytes_.load(std::memory_order_relaxed);
+    stats.disconnects = disconnects_.load(std::memory_order_relaxed);
+    stats.budget_hits = budget_hits_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FlowControl::MaybeReport() {
+    time_t now = CoarseClock::Now();
+    time_t next = next_report_.load(std::memory_order_relaxed);
+    if (now < next) return;
+    if (!next_report_.compare_exchange_strong(next, now + kReportInterval,
+                                              std::memory_order_relaxed)) {
+        return;
+    }
+    Stats s = GetStats();
+    IM_WARN("[flow] outstanding %lld bytes; paused %llu, resumed %llu, "
+            "dropped %llu packets (%llu bytes), disconnected %llu, "
+            "budget hits %llu",
+            static_cast<long long>(s.outstanding),
+            static_cast<unsigned long long>(s.paused),
+            static_cast<unsigned long long>(s.resumed),
+            static_cast<unsigned long long>(s.dropped_packets),
+            static_cast<unsigned long long>(s.dropped_bytes),
+            static_cast<unsigned long long>(s.disconnects),
+            static_cast<unsigned long long>(s.budget_hits));
+}
@@ -0,0 +1,314 @@
+#include "network/IoUringPoller.h"
+
+#ifdef IM_HAVE_IO_URING
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+#include "common/Logging.h"
+#include "network/Channel.h"
+
+static int SysSetup(unsigned entries, struct io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int SysEnter(int fd, unsigned to_submit, unsigned min_complete,
+                    unsigned flags, void *arg, size_t arg_size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, arg, arg_size));
+}
+
+// 共享环上的下标：内核和用户态各写一端，用 acquire/release 同步
+static unsigned LoadAcquire(const unsigned *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static void StoreRelease(unsigned *p, unsigned value) {
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+IoUringPoller::IoUringPoller(unsigned entries)
+    : sqes_(nullptr), sq_ring_(MAP_FAILED), cq_ring_(MAP_FAILED) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // CQ 开大一些：每个连接最多一个 poll 在等，峰值时完成事件比提交多
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+    ring_fd_ = SysSetup(entries, &params);
+    if (ring_fd_ == -1 && errno == EINVAL) {
+        // 老内核不认 COOP_TASKRUN
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        ring_fd_ = SysSetup(entries, &params);
+    }
+    if (ring_fd_ == -1) {
+        throw std::runtime_error(std::string("io_uring_setup failed: ") +
+                                 strerror(errno));
+    }
+    // NODROP：CQ满了内核先存着不丢；RSRC_TAGS 只用来确认内核 >= 5.13（poll update）
+    const unsigned required =
+        IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+    if ((params.features & required) != required) {
+        close(ring_fd_);
+        throw std::runtime_error("io_uring: kernel too old");
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ != MAP_FAILED) {
+        cq_ring_ = single_mmap
+                       ? sq_ring_
+                       : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, ring_fd_,
+                              IORING_OFF_CQ_RING);
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = MAP_FAILED;
+    if (cq_ring_ != MAP_FAILED) {
+        sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    }
+    if (sqes == MAP_FAILED) {
+        int saved_errno = errno;
+        Unmap();
+        close(ring_fd_);
+        throw std::runtime_error(std::string("io_uring mmap failed: ") +
+                                 strerror(saved_errno));
+    }
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_tail_local_ = *sq_tail_;
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    IM_INFO("io_uring poller ready: sq=%u cq=%u features=0x%x",
+            params.sq_entries, params.cq_entries, params.features);
+}
+
+IoUringPoller::~IoUringPoller() {
+    // 关掉 ring 时内核会取消所有还挂着的 poll
+    Unmap();
+    close(ring_fd_);
+}
+
+void IoUringPoller::Unmap() {
+    if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+}
+
+IoUringPoller::Registration &IoUringPoller::Slot(int fd) {
+    if (static_cast<size_t>(fd) >= registrations_.size()) {
+        registrations_.resize(
+            std::max<size_t>(fd + 1, registrations_.size() * 2));
+    }
+    return registrations_[fd];
+}
+
+int IoUringPoller::Enter(unsigned min_complete, unsigned flags, void *arg,
+                         size_t arg_size) {
+    unsigned to_submit = sq_tail_local_ - *sq_head_;
+    StoreRelease(sq_tail_, sq_tail_local_);
+    return SysEnter(ring_fd_, to_submit, min_complete, flags, arg, arg_size);
+}
+
+struct io_uring_sqe *IoUringPoller::GetSqe() {
+    while (sq_tail_local_ - LoadAcquire(sq_head_) >= sq_entries_) {
+        // 没有 SQPOLL，提交时内核同步取走sqe，提交完就有空位
+        if (Enter(0, 0, nullptr, 0) == -1 && errno != EINTR &&
+            errno != EAGAIN && errno != EBUSY) {
+            IM_ERROR("io_uring submit failed: %s", strerror(errno));
+        }
+    }
+    unsigned index = sq_tail_local_ & sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++sq_tail_local_;
+    return sqe;
+}
+
+void IoUringPoller::QueuePollAdd(int fd, Registration &reg) {
+    struct io_uring_sqe *sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = reg.mask;
+    sqe->user_data = UserData(fd, reg.gen);
+    reg.armed = true;
+    ++ctl_calls_;
+}
+
+void IoUringPoller::QueuePollRemove(uint64_t user_data) {
+    struct io_uring_sqe *sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = kInternalTag;
+    ++ctl_calls_;
+}
+
+void IoUringPoller::QueuePollUpdate(uint64_t user_data, uint32_t mask) {
+    // 原地改掩码，user_data 不变。poll 恰好已经完成的话返回 -ENOENT，
+    // 那个完成事件还在CQ里，取到时会按新掩码重新挂
+    struct io_uring_sqe *sqe = GetSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->len = IORING_POLL_UPDATE_EVENTS;
+    sqe->poll32_events = mask;
+    sqe->user_data = kInternalTag;
+    ++ctl_calls_;
+}
+
+void IoUringPoller::QueueRearm(int fd, Registration &reg) {
+    if (reg.rearm_queued) return;
+    reg.rearm_queued = true;
+    rearm_.push_back(fd);
+}
+
+void IoUringPoller::ArmPending() {
+    for (int fd : rearm_) {
+        Registration &reg = registrations_[fd];
+        reg.rearm_queued = false;
+        if (reg.channel == nullptr || reg.armed) continue;
+        reg.mask = reg.channel->Events();
+        if (reg.mask != 0) QueuePollAdd(fd, reg);
+    }
+    rearm_.clear();
+}
+
+void IoUringPoller::UpdateChannel(Channel *channel) {
+    int fd = channel->Fd();
+    Registration &reg = Slot(fd);
+    if (reg.channel != channel) {
+        if (reg.armed) QueuePollRemove(UserData(fd, reg.gen));
+        reg.channel = channel;
+        reg.armed = false;
+        ++reg.gen;
+    }
+    channel->SetAdded(true);
+    channel->SetArmed(true);
+    uint32_t mask = channel->Events();
+    if (!reg.armed) {
+        // 不在内核里等的，统一在下次 Poll 前挂上；这之间再怎么改掩码都不用进内核
+        if (mask != 0) QueueRearm(fd, reg);
+        return;
+    }
+    if (mask == reg.mask) return;
+    if (mask == 0) {
+        QueuePollRemove(UserData(fd, reg.gen));
+        reg.armed = false;
+        ++reg.gen;
+        return;
+    }
+    QueuePollUpdate(UserData(fd, reg.gen), mask);
+    reg.mask = mask;
+}
+
+void IoUringPoller::RemoveChannel(Channel *channel) {
+    if (!channel->IsAdded()) return;
+    channel->SetAdded(false);
+    int fd = channel->Fd();
+    if (static_cast<size_t>(fd) >= registrations_.size()) return;
+    Registration &reg = registrations_[fd];
+    if (reg.channel != channel) return;
+    // fd 可能在提交前就被关掉，按 user_data 摘除不受影响
+    if (reg.armed) QueuePollRemove(UserData(fd, reg.gen));
+    reg.channel = nullptr;
+    reg.armed = false;
+    ++reg.gen;
+}
+
+int IoUringPoller::Reap(std::vector<Event> &active) {
+    int count = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = LoadAcquire(cq_tail_);
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe &cqe = cqes_[head & cq_mask_];
+        if (cqe.user_data == kInternalTag) continue;
+        int fd = static_cast<int>(cqe.user_data & 0xffffffffu);
+        uint32_t gen = static_cast<uint32_t>(cqe.user_data >> 32);
+        if (static_cast<size_t>(fd) >= registrations_.size()) continue;
+        Registration &reg = registrations_[fd];
+        // 已经摘除或换过代的旧请求
+        if (reg.channel == nullptr || reg.gen != gen) continue;
+        reg.armed = false;
+        QueueRearm(fd, reg);
+        uint32_t revents;
+        if (cqe.res >= 0) {
+            revents = static_cast<uint32_t>(cqe.res);
+        } else if (cqe.res == -ECANCELED) {
+            continue;
+        } else {
+            revents = EPOLLERR;
+        }
+        // 改掩码和完成撞在一起时，完成事件可能带着已经不关心的位
+        revents &= reg.channel->Events() | EPOLLERR | EPOLLHUP;
+        if (revents == 0) continue;
+        active.push_back({reg.channel, revents});
+        ++count;
+    }
+    StoreRelease(cq_head_, head);
+    return count;
+}
+
+int IoUringPoller::Poll(int timeout_ms, std::vector<Event> &active) {
+    ArmPending();
+    int count = Reap(active);
+    if (count > 0) {
+        // 已经有现成的事件，只把攒下的请求交出去，不等
+        if (sq_tail_local_ != *sq_head_) Enter(0, 0, nullptr, 0);
+        return count;
+    }
+    // 提交和等待合成一次系统调用
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    memset(&arg, 0, sizeof(arg));
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    int ret = Enter(1, flags, timeout_ms >= 0 ? &arg : nullptr,
+                    timeout_ms >= 0 ? sizeof(arg) : 0);
+    int saved_errno = ret == -1 ? errno : 0;
+    // ETIME 是超时；EBUSY 是CQ溢出还没腾出来，先把能取的取走
+    if (ret == -1 && saved_errno != ETIME && saved_errno != EBUSY &&
+        saved_errno != EINTR) {
+        return -1;
+    }
+    count = Reap(active);
+    if (saved_errno == EINTR && count == 0) {
+        errno = EINTR;
+        return -1;
+    }
+    return count;
+}
+#endif
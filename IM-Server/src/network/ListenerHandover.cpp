@@ -0,0 +1,240 @@
+#include "network/ListenerHandover.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "common/Logging.h"
+
+namespace {
+// 和fd一起发过去的报头
+struct HandoverHeader {
+    uint32_t magic;
+    uint32_t count;
+};
+const uint32_t kHandoverMagic = 0x494d4644;  // "IMFD"
+const size_t kMaxHandoverFds = 64;
+// 新进程等旧进程回fd的时间
+const int kHandoverTimeoutSec = 3;
+const char kConfirm = 'R';
+
+bool FillAddress(const std::string &path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr->sun_path)) {
+        IM_WARN("Handover path too long: %s", path.c_str());
+        return false;
+    }
+    memcpy(addr->sun_path, path.c_str(), path.size());
+    return true;
+}
+
+// Channel 可能还在本批就绪事件里，等本轮事件处理完再删
+void DeferDelete(EventLoop *loop, std::unique_ptr<Channel> &channel) {
+    if (!channel) return;
+    channel->Remove();
+    Channel *raw = channel.release();
+    loop->QueueInLoop([raw] { delete raw; });
+}
+}  // namespace
+
+bool ListenerHandover::Fetch(const std::string &path, std::vector<int> *fds,
+                             int *peer_fd) {
+    struct sockaddr_un addr;
+    if (!FillAddress(path, &addr)) return false;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+    // 没有文件或者没人在听：没有旧进程，自己建监听socket
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                sizeof(addr)) == -1) {
+        close(fd);
+        return false;
+    }
+    struct timeval tv;
+    tv.tv_sec = kHandoverTimeoutSec;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    HandoverHeader header;
+    memset(&header, 0, sizeof(header));
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * kMaxHandoverFds)];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    int saved_errno = errno;
+
+    std::vector<int> received;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int *data = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+        received.insert(received.end(), data, data + count);
+    }
+    if (n != static_cast<ssize_t>(sizeof(header)) ||
+        header.magic != kHandoverMagic || header.count != received.size() ||
+        (msg.msg_flags & MSG_CTRUNC)) {
+        IM_WARN("Listener handover from %s failed (%zd bytes, %zu fds): %s",
+                path.c_str(), n, received.size(),
+                n == -1 ? strerror(saved_errno) : "bad message");
+        for (int received_fd : received) close(received_fd);
+        close(fd);
+        return false;
+    }
+    *fds = std::move(received);
+    *peer_fd = fd;
+    return true;
+}
+
+void ListenerHandover::Confirm(int peer_fd) {
+    if (write(peer_fd, &kConfirm, 1) != 1) {
+        IM_WARN("Listener handover confirm failed: %s", strerror(errno));
+    }
+    close(peer_fd);
+}
+
+ListenerHandover::ListenerHandover(EventLoop *loop, const std::string &path,
+                                   const std::vector<int> &listen_fds)
+    : loop_(loop), path_(path), listen_fds_(listen_fds) {}
+
+ListenerHandover::~ListenerHandover() {
+    // loop 此时可能已经析构，只关fd；path 可能已经归新进程，不删
+    if (peer_fd_ != -1) close(peer_fd_);
+    if (unix_fd_ != -1) close(unix_fd_);
+}
+
+bool ListenerHandover::Listen() {
+    struct sockaddr_un addr;
+    if (!FillAddress(path_, &addr)) return false;
+    unix_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (unix_fd_ == -1) return false;
+    // 上一个进程留下的（或者刚交接完的旧进程的）socket文件。
+    // 只删自己的socket文件，别人放在这个路径上的东西不动，bind 会失败
+    struct stat st;
+    if (lstat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode) &&
+        st.st_uid == getuid()) {
+        unlink(path_.c_str());
+    }
+    if (bind(unix_fd_, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) == -1 ||
+        chmod(path_.c_str(), 0600) == -1 || listen(unix_fd_, 4) == -1) {
+        IM_WARN("Listen for handover on %s failed: %s", path_.c_str(),
+                strerror(errno));
+        close(unix_fd_);
+        unix_fd_ = -1;
+        return false;
+    }
+    unix_channel_.reset(new Channel(loop_, unix_fd_));
+    unix_channel_->SetEventCallback([this](uint32_t) { this->HandleAccept(); });
+    unix_channel_->EnableReading();
+    IM_INFO("Waiting for listener handover on %s", path_.c_str());
+    return true;
+}
+
+void ListenerHandover::HandleAccept() {
+    int fd = accept4(unix_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) return;
+    if (peer_fd_ != -1) {
+        IM_WARN("Listener handover already in progress, reject another one");
+        close(fd);
+        return;
+    }
+    // 只交给同一个用户起的进程
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1 ||
+        cred.uid != getuid()) {
+        IM_WARN("Reject listener handover from another user");
+        close(fd);
+        return;
+    }
+    if (listen_fds_.size() > kMaxHandoverFds) {
+        IM_WARN("Too many listen sockets to hand over: %zu",
+                listen_fds_.size());
+        close(fd);
+        return;
+    }
+
+    HandoverHeader header;
+    header.magic = kHandoverMagic;
+    header.count = static_cast<uint32_t>(listen_fds_.size());
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * kMaxHandoverFds)];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    size_t fds_len = sizeof(int) * listen_fds_.size();
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE(fds_len);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds_len);
+    memcpy(CMSG_DATA(cmsg), listen_fds_.data(), fds_len);
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) !=
+        static_cast<ssize_t>(sizeof(header))) {
+        IM_WARN("Send listen sockets to pid %d failed: %s", cred.pid,
+                strerror(errno));
+        close(fd);
+        return;
+    }
+    IM_INFO("Sent %zu listen sockets to pid %d, waiting for it to take over",
+            listen_fds_.size(), cred.pid);
+    peer_fd_ = fd;
+    peer_channel_.reset(new Channel(loop_, peer_fd_));
+    peer_channel_->SetEventCallback([this](uint32_t) { this->HandlePeer(); });
+    peer_channel_->EnableReading();
+}
+
+void ListenerHandover::HandlePeer() {
+    char ack = 0;
+    ssize_t n = read(peer_fd_, &ack, 1);
+    if (n == -1 && (errno == EAGAIN || errno == EINTR)) return;
+    if (n == 1 && ack == kConfirm) {
+        IM_INFO("New process took over the listen sockets");
+        ClosePeer();
+        CloseListener();
+        if (takeover_callback_) takeover_callback_();
+        return;
+    }
+    // 新进程拿到fd之后没确认就退出了，它手里的那份随进程关掉，这边照常服务
+    IM_WARN("New process quit before taking over, keep serving");
+    ClosePeer();
+}
+
+void ListenerHandover::ClosePeer() {
+    DeferDelete(loop_, peer_channel_);
+    close(peer_fd_);
+    peer_fd_ = -1;
+}
+
+void ListenerHandover::CloseListener() {
+    DeferDelete(loop_, unix_channel_);
+    close(unix_fd_);
+    unix_fd_ = -1;
+}
@@ -0,0 +1,75 @@
+#include "network/MessageDispatcher.h"
+
+#include <exception>
+#include <string>
+
+#include "common/Logging.h"
+#include "common/Metrics.h"
+#include "network/Connection.h"
+#include "network/ThreadPool.h"
+
+MessageDispatcher &MessageDispatcher::GetInstance() {
+    static MessageDispatcher instance;
+    return instance;
+}
+
+void MessageDispatcher::Register(uint32_t msg_type, ExecMode mode,
+                                 MessageHandler handler) {
+    if (msg_type >= table_.size()) table_.resize(msg_type + 1);
+    table_[msg_type].mode = mode;
+    table_[msg_type].handler = std::move(handler);
+    MetricsRegistry &registry = MetricsRegistry::GetInstance();
+    table_[msg_type].frames = registry.GetCounter(
+        "im_frames_received_total", "Frames received by msg_type",
+        "msg_type=\"" + std::to_string(msg_type) + "\"");
+    if (unknown_frames_ == nullptr) {
+        unknown_frames_ = registry.GetCounter(
+            "im_frames_received_total", "Frames received by msg_type",
+            "msg_type=\"unknown\"");
+    }
+}
+
+bool MessageDispatcher::Dispatch(const std::shared_ptr<Connection> &conn,
+                                 const Codec::Frame &frame) const {
+    uint32_t msg_type = frame.msg_type;
+    if (msg_type >= table_.size() || !table_[msg_type].handler) {
+        if (unknown_frames_ != nullptr) unknown_frames_->Inc();
+        IM_WARN("Unknown msg_type %u on fd %d, dropped.", msg_type,
+                conn->GetFd());
+        return false;
+    }
+    const Entry &entry = table_[msg_type];
+    entry.frames->Inc();
+    if (entry.mode == ExecMode::kInline) {
+        // 不拷贝包体，也不跨线程
+        Invoke(entry, conn, frame);
+        return true;
+    }
+    ThreadPool &pool = entry.mode == ExecMode::kCpu
+                           ? ThreadPool::GetCpuInstance()
+                           : ThreadPool::GetInstance();
+    // 交给业务线程的包体只在这里拷贝一次，之后随任务一路move。
+    // 表在启动后不再修改，任务里直接引用表项。
+    // 经由连接的 Strand 投递：同一连接的消息按收包顺序处理
+    conn->GetStrand().Post(pool, [&entry, conn, msg_type, flags = frame.flags,
+                                  body = std::string(frame.body)] {
+        Codec::Frame owned;
+        owned.msg_type = msg_type;
+        owned.flags = flags;
+        owned.body = body;
+        Invoke(entry, conn, owned);
+    });
+    return true;
+}
+
+void MessageDispatcher::Invoke(const Entry &entry,
+                               const std::shared_ptr<Connection> &conn,
+                               const Codec::Frame &frame) {
+    try {
+        entry.handler(conn, frame);
+    } catch (const std::exception &e) {
+        // 一个坏包不能把IO线程或者工作线程带崩
+        IM_ERROR("Handle msg_type %u on fd %d failed: %s", frame.msg_type,
+                 conn->GetFd(), e.what());
+    }
+}
@@ -0,0 +1,119 @@
+#include "network/OutputQueue.h"
+
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+
+void OutputQueue::Push(PacketPtr packet, bool droppable) {
+    if (!packet || packet->empty()) return;
+    pending_bytes_ += packet->size();
+    packets_.push_back(Entry{std::move(packet), droppable});
+}
+
+void OutputQueue::Clear() {
+    packets_.clear();
+    head_offset_ = 0;
+    pending_bytes_ = 0;
+}
+
+CorkMode ParseCorkMode(const std::string &name) {
+    if (name == "msg_more") return CorkMode::kMsgMore;
+    if (name == "tcp_cork") return CorkMode::kTcpCork;
+    return CorkMode::kNone;
+}
+
+size_t OutputQueue::DropOldest(size_t target, size_t *packets) {
+    size_t dropped = 0;
+    size_t count = 0;
+    // 保留的包按原顺序往前挪
+    size_t keep = 0;
+    for (size_t i = 0; i < packets_.size(); ++i) {
+        Entry &entry = packets_[i];
+        bool started = (i == 0 && head_offset_ > 0);
+        if (pending_bytes_ > target && entry.droppable && !started) {
+            pending_bytes_ -= entry.packet->size();
+            dropped += entry.packet->size();
+            ++count;
+            continue;
+        }
+        if (keep != i) packets_[keep] = std::move(entry);
+        ++keep;
+    }
+    packets_.resize(keep);
+    if (packets) *packets = count;
+    return dropped;
+}
+
+static void SetCork(int fd, int on) {
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+}
+
+ssize_t OutputQueue::WriteTo(int fd, CorkMode mode, WriteStats *stats) {
+    struct iovec iov[IOV_MAX];
+    ssize_t total = 0;
+    // 一次 sendmsg 就能写完时什么都不用做
+    bool corked = mode == CorkMode::kTcpCork && packets_.size() > IOV_MAX;
+    if (corked) SetCork(fd, 1);
+    while (!packets_.empty()) {
+        // 1、把排队的包依次填进iovec，队首包跳过已写出的部分
+        size_t count = std::min<size_t>(packets_.size(), IOV_MAX);
+        size_t offered = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const std::string &data = *packets_[i].packet;
+            size_t skip = (i == 0) ? head_offset_ : 0;
+            iov[i].iov_base = const_cast<char *>(data.data()) + skip;
+            iov[i].iov_len = data.size() - skip;
+            offered += iov[i].iov_len;
+        }
+        // 2、用sendmsg而不是writev：MSG_NOSIGNAL 避免对端已关时收到 SIGPIPE
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        int flags = MSG_NOSIGNAL;
+        if (mode == CorkMode::kMsgMore && count < packets_.size()) {
+            flags |= MSG_MORE;
+        }
+        ssize_t n = sendmsg(fd, &msg, flags);
+        if (stats) ++stats->calls;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int saved_errno = errno;
+            if (stats && saved_errno != EAGAIN && saved_errno != EWOULDBLOCK) {
+                stats->error = saved_errno;
+            }
+            if (corked) SetCork(fd, 0);
+            errno = saved_errno;
+            return total > 0 ? total : -1;
+        }
+        size_t done = Consume(n);
+        if (stats) stats->packets += done;
+        total += n;
+        // 3、没写满说明内核缓冲区满了，等下次EPOLLOUT
+        if (static_cast<size_t>(n) < offered) break;
+    }
+    // 关掉 cork 时内核把攒着的数据立即发出
+    if (corked) SetCork(fd, 0);
+    return total;
+}
+
+size_t OutputQueue::Consume(size_t n) {
+    pending_bytes_ -= n;
+    size_t done = 0;
+    while (n > 0) {
+        size_t left = packets_.front().packet->size() - head_offset_;
+        if (n < left) {
+            head_offset_ += n;
+            return done;
+        }
+        n -= left;
+        packets_.pop_front();
+        head_offset_ = 0;
+        ++done;
+    }
+    return done;
+}
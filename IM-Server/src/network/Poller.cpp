@@ -0,0 +1,24 @@
+#include "network/Poller.h"
+
+#include <exception>
+
+#include "common/Logging.h"
+#include "network/EpollPoller.h"
+#include "network/IoUringPoller.h"
+
+std::unique_ptr<Poller> Poller::Create(const std::string &name) {
+    if (name == "io_uring") {
+#ifdef IM_HAVE_IO_URING
+        try {
+            return std::unique_ptr<Poller>(new IoUringPoller());
+        } catch (const std::exception &e) {
+            IM_WARN("%s, fall back to epoll", e.what());
+        }
+#else
+        IM_WARN("io_uring poller not compiled in, fall back to epoll");
+#endif
+    } else if (name != "epoll") {
+        IM_WARN("Unknown poller '%s', use epoll", name.c_str());
+    }
+    return std::unique_ptr<Poller>(new EpollPoller());
+}
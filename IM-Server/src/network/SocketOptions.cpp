@@ -0,0 +1,83 @@
+#include "network/SocketOptions.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "common/Logging.h"
+
+// 已经打过警告的选项，每个选项一位。每个连接都会设置一遍，失败原因都一样，只报一次
+static std::atomic<uint32_t> g_warned{0};
+
+enum OptionBit {
+    kBitNoDelay,
+    kBitSendBuf,
+    kBitRecvBuf,
+    kBitQuickAck,
+    kBitBusyPoll,
+    kBitUserTimeout,
+    kBitKeepalive,
+};
+
+static bool SetIntOption(int fd, int level, int name, int value,
+                         OptionBit bit, const char *label) {
+    if (setsockopt(fd, level, name, &value, sizeof(value)) == 0) return true;
+    uint32_t mask = 1u << bit;
+    if (!(g_warned.fetch_or(mask, std::memory_order_relaxed) & mask)) {
+        IM_WARN("setsockopt %s=%d failed: %s", label, value, strerror(errno));
+    }
+    return false;
+}
+
+bool ApplySocketOptions(int fd, const SocketOptions &options) {
+    bool ok = true;
+    if (options.no_delay) {
+        ok &= SetIntOption(fd, IPPROTO_TCP, TCP_NODELAY, 1, kBitNoDelay,
+                           "TCP_NODELAY");
+    }
+    if (options.send_buf > 0) {
+        ok &= SetIntOption(fd, SOL_SOCKET, SO_SNDBUF, options.send_buf,
+                           kBitSendBuf, "SO_SNDBUF");
+    }
+    if (options.recv_buf > 0) {
+        ok &= SetIntOption(fd, SOL_SOCKET, SO_RCVBUF, options.recv_buf,
+                           kBitRecvBuf, "SO_RCVBUF");
+    }
+    if (options.quick_ack) {
+        ok &= SetIntOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, kBitQuickAck,
+                           "TCP_QUICKACK");
+    }
+    if (options.busy_poll_us > 0) {
+        ok &= SetIntOption(fd, SOL_SOCKET, SO_BUSY_POLL, options.busy_poll_us,
+                           kBitBusyPoll, "SO_BUSY_POLL");
+    }
+    if (options.user_timeout_ms > 0) {
+        ok &= SetIntOption(fd, IPPROTO_TCP, TCP_USER_TIMEOUT,
+                           options.user_timeout_ms, kBitUserTimeout,
+                           "TCP_USER_TIMEOUT");
+    }
+    if (options.keepalive) {
+        ok &= SetIntOption(fd, SOL_SOCKET, SO_KEEPALIVE, 1, kBitKeepalive,
+                           "SO_KEEPALIVE") &&
+              SetIntOption(fd, IPPROTO_TCP, TCP_KEEPIDLE,
+                           options.keepalive_idle, kBitKeepalive,
+                           "TCP_KEEPIDLE") &&
+              SetIntOption(fd, IPPROTO_TCP, TCP_KEEPINTVL,
+                           options.keepalive_interval, kBitKeepalive,
+                           "TCP_KEEPINTVL") &&
+              SetIntOption(fd, IPPROTO_TCP, TCP_KEEPCNT,
+                           options.keepalive_count, kBitKeepalive,
+                           "TCP_KEEPCNT");
+    }
+    return ok;
+}
+
+void RearmQuickAck(int fd) {
+    SetIntOption(fd, IPPROTO_TCP, TCP_QUICKACK, 1, kBitQuickAck,
+                 "TCP_QUICKACK");
+}
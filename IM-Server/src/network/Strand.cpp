@@ -0,0 +1,41 @@
+#include "network/Strand.h"
+
+void Strand::Post(ThreadPool &pool, Task task) {
+    Item item;
+    item.pool = &pool;
+    item.task = std::move(task);
+    queue_.Push(std::move(item));
+    // 原来没有任务在跑，由我们启动；否则正在跑的执行者会接着取到它
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        Schedule(&pool);
+    }
+}
+
+void Strand::Schedule(ThreadPool *pool) {
+    pool->Enqueue([self = shared_from_this(), pool] { self->Run(pool); });
+}
+
+void Strand::Run(ThreadPool *pool) {
+    for (int executed = 0;; ++executed) {
+        if (!has_front_) {
+            // pending_ > 0 保证队列里一定有（或马上会挂好）一个任务
+            queue_.Pop(front_);
+            has_front_ = true;
+        }
+        if (front_.pool != pool) {
+            // 下一个任务要去别的池：整个 Strand 搬过去，顺序不变
+            Schedule(front_.pool);
+            return;
+        }
+        if (executed >= kMaxBatch) {
+            Schedule(pool);
+            return;
+        }
+        Task task = std::move(front_.task);
+        has_front_ = false;
+        task();
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return;  // 没有后续任务，下一个投递者会重新启动
+        }
+    }
+}
@@ -1,73 +1,418 @@
 #include "network/TcpServer.h"
 
-#include <fcntl.h>
+#include <linux/filter.h>
 
+#include <algorithm>
 #include <cstring>
-#include <iostream>
 #include <memory>
+#include <thread>
 #include <stdexcept>
-static void SetNonBlocking(int fd) {
-    int flags = fcntl(fd, F_GETFL, 0);
-    if (flags == -1) {
-        std::cerr << "fcntl get failed" << std::endl;
-        return;
+
+#include "common/BlockPool.h"
+#include "common/Logging.h"
+#include "common/Metrics.h"
+#include "network/Compressor.h"
+#include "network/FlowControl.h"
+// 给 reuseport 组挂一个 cBPF：按收包CPU号对分片数取模选socket。
+// 配合第i个loop线程绑第i个CPU，连接由哪个核收包就落在哪个核的loop上。
+static bool AttachCpuSteering(int listen_fd, size_t shards) {
+    struct sock_filter code[] = {
+        // A = 当前CPU号
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+         static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+        // A = A % shards
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(shards)},
+        // 返回 socket 下标
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+    return setsockopt(listen_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                      sizeof(prog)) == 0;
+}
+
+// 内存池统计日志间隔
+static const int kPoolStatsIntervalMs = 60 * 1000;
+
+TcpServer::TcpServer(const std::string &ip, uint16_t port,
+                     const TcpServerOptions &options)
+    : ip_(ip),
+      port_(port),
+      options_(options),
+      cork_mode_(ParseCorkMode(options.cork_mode)),
+      trigger_mode_(ParseTriggerMode(options.trigger_mode)),
+      loop_(new EventLoop(options.poller)) {
+    if (!loop_->SupportsMode(trigger_mode_)) {
+        IM_WARN("%s poller does not support %s trigger mode, use level",
+                loop_->PollerName(), TriggerModeName(trigger_mode_));
+        trigger_mode_ = TriggerMode::kLevel;
+    }
+    bool sharded = options_.reuseport_shards > 0;
+    // 分片模式下每个分片都是一个独立的loop线程，不再另开子reactor
+    size_t num_loops = sharded ? options_.reuseport_shards : options_.io_threads;
+    thread_pool_.reset(new EventLoopThreadPool(loop_.get(), num_loops,
+                                               options_.balance_policy,
+                                               options_.poller));
+    size_t num_listeners = sharded ? options_.reuseport_shards : 1;
+    // 有旧进程在跑就直接用它的监听socket，不重新 bind
+    std::vector<int> inherited;
+    if (!options_.upgrade_path.empty() &&
+        ListenerHandover::Fetch(options_.upgrade_path, &inherited,
+                                &handover_peer_fd_)) {
+        bool usable = true;
+        for (int fd : inherited) usable = usable && IsOurListenSocket(fd);
+        if (!usable) {
+            IM_WARN("Listen sockets from the old process are not on port %u",
+                    port_);
+            for (int fd : inherited) close(fd);
+            inherited.clear();
+            close(handover_peer_fd_);
+            handover_peer_fd_ = -1;
+        } else {
+            IM_INFO("Took over %zu listen sockets from the old process",
+                    inherited.size());
+        }
+        if (usable && inherited.size() != num_listeners) {
+            // 多出来的监听socket关掉后，排在它们队列里的连接要等旧进程退出才会被重置
+            IM_WARN("Old process had %zu listen sockets, now %zu",
+                    inherited.size(), num_listeners);
+        }
+    }
+    for (size_t i = num_listeners; i < inherited.size(); ++i) {
+        close(inherited[i]);
+    }
+    for (size_t i = 0; i < num_listeners; ++i) {
+        if (i < inherited.size()) {
+            listen_fds_.push_back(inherited[i]);
+            continue;
+        }
+        try {
+            listen_fds_.push_back(CreateListenSocket(sharded));
+        } catch (...) {
+            for (int fd : listen_fds_) close(fd);
+            if (handover_peer_fd_ != -1) close(handover_peer_fd_);
+            throw;
+        }
     }
-    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-        std::cerr << "fcntl set failed" << std::endl;
+    if (sharded && options_.cpu_steering &&
+        !AttachCpuSteering(listen_fds_[0], listen_fds_.size())) {
+        IM_WARN("Attach reuseport cBPF failed: %s", strerror(errno));
     }
+    IM_INFO("Tcp Server初始化 %s:%u", ip_.c_str(), port_);
 }
-TcpServer::TcpServer(const std::string &ip, uint16_t port)
-    : ip_(ip), port_(port), listen_fd_(-1), loop_(new EventLoop()) {
-    // 1、创建tcp socket
-    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_fd_ == -1) throw std::runtime_error("创建失败");
-    // 增加非阻塞
-    SetNonBlocking(listen_fd_);
+
+int TcpServer::CreateListenSocket(bool reuseport) {
+    // 1、创建非阻塞的tcp socket
+    int listen_fd =
+        socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) throw std::runtime_error("创建失败");
     // 2、设置端口复用
     int opt = 1;
-    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport &&
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) ==
+            -1) {
+        close(listen_fd);
+        throw std::runtime_error("设置SO_REUSEPORT失败");
+    }
     // 3、绑定ip与端口
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port_);
     server_addr.sin_addr.s_addr = inet_addr(ip_.c_str());
-    if (bind(listen_fd_, (struct sockaddr *)&server_addr,
+    if (bind(listen_fd, (struct sockaddr *)&server_addr,
              sizeof(server_addr)) == -1) {
-        close(listen_fd_);
+        close(listen_fd);
         throw std::runtime_error("绑定失败");
     }
     // 4、开始监听
-    if (listen(listen_fd_, 128) == -1) {
-        close(listen_fd_);
+    if (listen(listen_fd, options_.backlog) == -1) {
+        close(listen_fd);
         throw std::runtime_error("监听失败");
     }
-    std::cout << "Tcp Server初始化 " << ip_ << ":" << port_ << std::endl;
+    return listen_fd;
+}
+
+bool TcpServer::IsOurListenSocket(int fd) const {
+    int accepting = 0;
+    socklen_t len = sizeof(accepting);
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    return getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &len) == 0 &&
+           accepting &&
+           getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr),
+                       &addr_len) == 0 &&
+           addr.sin_family == AF_INET && ntohs(addr.sin_port) == port_;
 }
+
 TcpServer::~TcpServer() {
-    if (listen_fd_ != -1) {
-        close(listen_fd_);
-        std::cout << "Tcp Server关闭" << std::endl;
+    if (handover_peer_fd_ != -1) close(handover_peer_fd_);
+    for (int listen_fd : listen_fds_) {
+        close(listen_fd);
     }
+    IM_INFO("Tcp Server关闭");
 }
+
 void TcpServer::start() {
-    loop_->AddEvent(listen_fd_, EPOLLIN, [this](uint32_t revents) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(this->listen_fd_,
-                               (struct sockaddr *)&client_addr, &client_len);
-        if (client_fd != -1) {
-            std::cout << "New Client Connected! fd: " << client_fd << std::endl;
-            // 1、创建专属connection对象
-            std::unique_ptr<Connection> conn(
-                new Connection(loop_.get(), client_fd));
-            // 2、告诉Connection
-            conn->SetCloseCallback(
-                [this](int fd) { this->connections_.erase(fd); });
-            // 3、将其保存到tcp中
-            connections_[client_fd] = std::move(conn);
+    bool sharded = options_.reuseport_shards > 0;
+    thread_pool_->Start(sharded && options_.cpu_steering);
+    // 忙轮询只开在收发连接的loop上；没有子loop时主loop自己收发。
+    // 核数不比这些loop多的话，转着等只会和对端、业务线程抢CPU，反而更慢
+    const auto &io_loops = thread_pool_->GetAllLoops();
+    int loop_spin_us = options_.loop_spin_us;
+    if (loop_spin_us > 0 &&
+        std::thread::hardware_concurrency() <=
+            std::max<size_t>(io_loops.size(), 1)) {
+        IM_WARN("Only %u CPUs for %zu io loops, loop busy poll disabled",
+                std::thread::hardware_concurrency(),
+                std::max<size_t>(io_loops.size(), 1));
+        loop_spin_us = 0;
+    }
+    for (EventLoop *io_loop : io_loops) io_loop->SetBusyPoll(loop_spin_us);
+    if (io_loops.empty()) loop_->SetBusyPoll(loop_spin_us);
+    AcceptorOptions accept_options = options_.accept;
+    // 限速是总量，分片时每个监听socket各分一份
+    accept_options.rate /= listen_fds_.size();
+    accept_options.burst /= listen_fds_.size();
+    if (sharded) {
+        // 每个分片loop在自己线程里注册自己的监听socket，连接留在接它的loop
+        const auto &loops = thread_pool_->GetAllLoops();
+        for (size_t i = 0; i < listen_fds_.size(); ++i) {
+            EventLoop *shard_loop = loops[i];
+            Acceptor *acceptor =
+                new Acceptor(shard_loop, listen_fds_[i], accept_options);
+            acceptors_.emplace_back(acceptor);
+            acceptor->SetNewConnectionCallback([this, shard_loop](int fd) {
+                this->NewConnection(fd, shard_loop);
+            });
+            shard_loop->RunInLoop([acceptor] { acceptor->Listen(); });
         }
-    });
-    std::cout << "IM server start with epoll" << std::endl;
+        IM_INFO("IM server start with %zu SO_REUSEPORT shards (%s, %s)",
+                listen_fds_.size(), loop_->PollerName(),
+                TriggerModeName(trigger_mode_));
+    } else {
+        Acceptor *acceptor =
+            new Acceptor(loop_.get(), listen_fds_[0], accept_options);
+        acceptors_.emplace_back(acceptor);
+        // 由策略挑一个子loop
+        acceptor->SetNewConnectionCallback([this](int fd) {
+            this->NewConnection(fd, thread_pool_->GetNextLoop());
+        });
+        acceptor->Listen();
+        IM_INFO("IM server start with %s (%s)", loop_->PollerName(),
+                TriggerModeName(trigger_mode_));
+    }
+    if (handover_peer_fd_ != -1) {
+        // 已经开始accept了，旧进程可以让位
+        ListenerHandover::Confirm(handover_peer_fd_);
+        handover_peer_fd_ = -1;
+    }
+    if (!options_.upgrade_path.empty()) {
+        handover_.reset(new ListenerHandover(loop_.get(), options_.upgrade_path,
+                                             listen_fds_));
+        handover_->SetTakeoverCallback([this] { this->BeginDrain(); });
+        handover_->Listen();
+    }
+    RegisterMetrics();
+    if (options_.admin_port != 0) {
+        admin_.reset(
+            new AdminServer(loop_.get(), options_.admin_ip, options_.admin_port));
+        admin_->Start();
+    }
+    pool_stats_timer_.callback = [this] { this->ReportPoolStats(); };
+    loop_->GetTimerWheel().Add(&pool_stats_timer_,
+                               kPoolStatsIntervalMs / EventLoop::kTickMs);
     loop_->Loop();
-}
\ No newline at end of file
+}
+
+void TcpServer::ReportPoolStats() {
+    BlockPool::Stats stats = BlockPool::GetStats();
+    uint64_t total = stats.hits + stats.misses;
+    IM_INFO("[pool] hits %llu, misses %llu (%.1f%% hit), refills %llu, "
+            "oversize %llu, cached %llu bytes",
+            static_cast<unsigned long long>(stats.hits),
+            static_cast<unsigned long long>(stats.misses),
+            total ? 100.0 * stats.hits / total : 0.0,
+            static_cast<unsigned long long>(stats.refills),
+            static_cast<unsigned long long>(stats.oversize),
+            static_cast<unsigned long long>(stats.cached_bytes));
+    loop_->GetTimerWheel().Add(&pool_stats_timer_,
+                               kPoolStatsIntervalMs / EventLoop::kTickMs);
+}
+
+void TcpServer::RegisterMetrics() {
+    MetricsRegistry &registry = MetricsRegistry::GetInstance();
+    registry.AddCounterFunc("im_accepted_connections_total",
+                            "Connections accepted", "", [] {
+                                return static_cast<double>(
+                                    Acceptor::GetStats().accepted);
+                            });
+    registry.AddCounterFunc("im_shed_connections_total",
+                            "Connections closed right away for lack of fds",
+                            "", [] {
+                                return static_cast<double>(
+                                    Acceptor::GetStats().shed);
+                            });
+    registry.AddCounterFunc("im_accept_throttled_total",
+                            "Times accepting paused by the rate limit", "",
+                            [] {
+                                return static_cast<double>(
+                                    Acceptor::GetStats().throttled);
+                            });
+    registry.AddCounterFunc("im_accept_fd_paused_total",
+                            "Times accepting paused with no fd left to shed",
+                            "", [] {
+                                return static_cast<double>(
+                                    Acceptor::GetStats().fd_paused);
+                            });
+    // 没有子loop时主loop自己收发
+    std::vector<EventLoop *> io_loops = thread_pool_->GetAllLoops();
+    if (io_loops.empty()) io_loops.push_back(loop_.get());
+    for (size_t i = 0; i < io_loops.size(); ++i) {
+        const EventLoop *io_loop = io_loops[i];
+        const EventLoop::IoStats *io = &io_loop->GetIoStats();
+        std::string labels = "loop=\"" + std::to_string(i) + "\"";
+        registry.AddGaugeFunc("im_live_connections",
+                              "Connections owned by each io loop", labels,
+                              [io_loop] {
+                                  return static_cast<double>(
+                                      io_loop->ConnectionCount());
+                              });
+        auto add_counter = [&](const char *name, const char *help,
+                               const std::atomic<uint64_t> *value) {
+            registry.AddCounterFunc(name, help, labels, [value] {
+                return static_cast<double>(
+                    value->load(std::memory_order_relaxed));
+            });
+        };
+        add_counter("im_bytes_in_total", "Bytes read from connections",
+                    &io->bytes_in);
+        add_counter("im_bytes_out_total", "Bytes written to connections",
+                    &io->bytes);
+        add_counter("im_frames_in_total", "Complete frames received",
+                    &io->frames);
+        add_counter("im_packets_out_total", "Packets fully written",
+                    &io->packets);
+        add_counter("im_write_calls_total", "sendmsg calls", &io->write_calls);
+        add_counter("im_loop_polls_total", "Times the loop woke from poll",
+                    &io->polls);
+        add_counter("im_loop_wakeups_total",
+                    "Cross-thread eventfd wakeups", &io->wakeups);
+    }
+    registry.AddGaugeFunc("im_output_pending_bytes",
+                          "Bytes queued for sending across all connections",
+                          "", [] {
+                              return static_cast<double>(
+                                  FlowControl::GetInstance()
+                                      .GetStats()
+                                      .outstanding);
+                          });
+    registry.AddCounterFunc("im_output_dropped_packets_total",
+                            "Droppable packets discarded under backpressure",
+                            "", [] {
+                                return static_cast<double>(
+                                    FlowControl::GetInstance()
+                                        .GetStats()
+                                        .dropped_packets);
+                            });
+    registry.AddCounterFunc("im_compressed_frames_total",
+                            "Frames sent compressed", "", [] {
+                                return static_cast<double>(
+                                    Compressor::GetInstance()
+                                        .GetStats()
+                                        .compressed);
+                            });
+    registry.AddGaugeFunc("im_pool_cached_bytes",
+                          "Idle bytes held by the block pool depot", "", [] {
+                              return static_cast<double>(
+                                  BlockPool::GetStats().cached_bytes);
+                          });
+    registry.AddCounterFunc("im_pool_misses_total",
+                            "Block pool allocations that hit the system "
+                            "allocator",
+                            "", [] {
+                                return static_cast<double>(
+                                    BlockPool::GetStats().misses);
+                            });
+}
+
+void TcpServer::BeginDrain() {
+    // 监听socket还开着（新进程在用同一个），只是这边不再 accept
+    for (auto &acceptor : acceptors_) {
+        Acceptor *raw = acceptor.get();
+        raw->GetLoop()->RunInLoop([raw] { raw->Stop(); });
+    }
+    // 抓取也交给新进程
+    if (admin_) admin_->Stop();
+    drain_ticks_left_ = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::max(options_.drain_timeout, 0)) * 1000 /
+               EventLoop::kTickMs);
+    IM_INFO("Stop accepting, draining connections within %d seconds",
+            options_.drain_timeout);
+    drain_timer_.callback = [this] { this->DrainTick(); };
+    loop_->GetTimerWheel().Add(&drain_timer_, 0);
+}
+
+void TcpServer::DrainTick() {
+    std::vector<std::shared_ptr<Connection>> live;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        for (const auto &conn : connections_) {
+            if (conn) live.push_back(conn);
+        }
+    }
+    if (live.empty()) {
+        IM_INFO("All connections drained, exit");
+        loop_->Quit();
+        return;
+    }
+    // 剩下的连接平摊到剩下的tick里，最后一个tick全部关掉
+    size_t batch = drain_ticks_left_ > 1
+                       ? (live.size() + drain_ticks_left_ - 1) / drain_ticks_left_
+                       : live.size();
+    IM_INFO("Draining: %zu connections left, closing %zu", live.size(), batch);
+    for (size_t i = 0; i < batch; ++i) live[i]->Shutdown();
+    if (drain_ticks_left_ > 0) --drain_ticks_left_;
+    // 在时间轮回调里，延迟1就是下一个tick
+    loop_->GetTimerWheel().Add(&drain_timer_, 1);
+}
+
+void TcpServer::NewConnection(int client_fd, EventLoop *io_loop) {
+    // 1、之后这个连接的读写都在io_loop上
+    io_loop->IncConnectionCount();
+    // 2、创建专属connection对象：控制块和对象在同一个池块里
+    auto conn = std::allocate_shared<Connection>(PoolAllocator<Connection>(),
+                                                 io_loop, client_fd);
+    // 3、告诉Connection，断开时找TcpServer摘除自己
+    conn->SetCloseCallback([this](int fd) { this->RemoveConnection(fd); });
+    conn->SetIdleTimeout(options_.idle_timeout);
+    conn->SetCorkMode(cork_mode_);
+    conn->SetTriggerMode(trigger_mode_);
+    conn->SetQuickAck(options_.accept.socket.quick_ack);
+    // 4、将其保存到tcp中
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (static_cast<size_t>(client_fd) >= connections_.size()) {
+            connections_.resize(client_fd + 1);
+        }
+        connections_[client_fd] = conn;
+    }
+    // 5、在io_loop线程里注册epoll
+    io_loop->RunInLoop([conn] { conn->ConnectEstablished(); });
+}
+
+void TcpServer::RemoveConnection(int fd) {
+    std::shared_ptr<Connection> conn;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (fd < 0 || static_cast<size_t>(fd) >= connections_.size()) return;
+        conn = std::move(connections_[fd]);
+        if (!conn) return;
+    }
+    EventLoop *io_loop = conn->GetLoop();
+    io_loop->DecConnectionCount();
+    // 延后到本轮事件处理完再摘除epoll，conn被lambda持有，保证回调期间不析构
+    io_loop->QueueInLoop([conn] { conn->ConnectDestroyed(); });
+}
@@ -0,0 +1,249 @@
+#include "network/ThreadPool.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+
+#include "common/Config.h"
+#include "common/Logging.h"
+#include "common/Metrics.h"
+
+// 当前线程所属的池和worker，用来判断 Enqueue 是不是池内派生的任务
+static thread_local ThreadPool *tls_pool = nullptr;
+static thread_local void *tls_worker = nullptr;
+
+static void FutexWait(std::atomic<uint32_t> *addr, uint32_t expected) {
+    // 只在 *addr 仍等于 expected 时睡，避免错过唤醒
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr),
+            FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static void FutexWake(std::atomic<uint32_t> *addr, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr),
+            FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+ThreadPool &ThreadPool::GetInstance() {
+    static ThreadPool instance(Config::GetInstance().GetBlockingThreads(),
+                               "blocking");
+    return instance;
+}
+
+ThreadPool &ThreadPool::GetCpuInstance() {
+    static ThreadPool instance(Config::GetInstance().GetCpuThreads(), "cpu");
+    return instance;
+}
+
+ThreadPool::ThreadPool(size_t num_threads, const std::string &name)
+    : spin_rounds_(std::thread::hardware_concurrency() > 1 ? kSpinRounds : 0),
+      inject_busy_(false),
+      inject_size_(0),
+      sleepers_(0),
+      stop_(false),
+      name_(name) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // 先把所有worker建好再起线程，偷取时遍历 workers_ 不用加锁
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(new Worker());
+        workers_.back()->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_[i]->thread = std::thread([this, i] { this->WorkerLoop(i); });
+    }
+    if (!name_.empty()) {
+        MetricsRegistry &registry = MetricsRegistry::GetInstance();
+        std::string labels = "pool=\"" + name_ + "\"";
+        wait_histogram_ = registry.GetHistogram(
+            "im_threadpool_wait_seconds",
+            "Time tasks spent queued before a worker picked them up", labels,
+            1e-6);
+        registry.AddGaugeFunc("im_threadpool_queue_depth",
+                              "Tasks queued and not yet started", labels,
+                              [this] {
+                                  return static_cast<double>(this->QueueDepth());
+                              });
+        registry.AddGaugeFunc("im_threadpool_threads", "Worker threads",
+                              labels,
+                              [this] {
+                                  return static_cast<double>(this->Size());
+                              });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    if (!name_.empty()) {
+        // 抓取时不能再回调到已经析构的池
+        MetricsRegistry &registry = MetricsRegistry::GetInstance();
+        std::string labels = "pool=\"" + name_ + "\"";
+        registry.AddGaugeFunc("im_threadpool_queue_depth",
+                              "Tasks queued and not yet started", labels,
+                              [] { return 0.0; });
+        registry.AddGaugeFunc("im_threadpool_threads", "Worker threads",
+                              labels, [] { return 0.0; });
+    }
+    stop_.store(true, std::memory_order_seq_cst);
+    NotifyAll();
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+size_t ThreadPool::QueueDepth() const {
+    size_t depth = inject_size_.load(std::memory_order_relaxed);
+    for (const auto &worker : workers_) depth += worker->deque.Size();
+    return depth;
+}
+
+void ThreadPool::Enqueue(Task task) {
+    Item *item = new Item{std::move(task), 0};
+    if (wait_histogram_ != nullptr) item->enqueue_us = MetricNowUs();
+    if (tls_pool == this) {
+        // 池内任务派生的子任务留在本worker，缓存是热的
+        static_cast<Worker *>(tls_worker)->deque.Push(item);
+    } else {
+        // 先加计数再入队，计数只会多估不会少估
+        inject_size_.fetch_add(1, std::memory_order_relaxed);
+        inject_queue_.Push(item);
+    }
+    // 和 Park 里的 sleepers_++ / 再检查 配对，保证不会漏唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    NotifyOne();
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    Worker &self = *workers_[index];
+    tls_pool = this;
+    tls_worker = &self;
+    IM_DEBUG("Worker thread %zu start.", index);
+    while (true) {
+        Item *task = FindTask(self, index);
+        if (task == nullptr) {
+            for (int i = 0; i < spin_rounds_ && task == nullptr; ++i) {
+                CpuRelax();
+                task = FindTask(self, index);
+            }
+            for (int i = 0; i < kYieldRounds && task == nullptr; ++i) {
+                std::this_thread::yield();
+                task = FindTask(self, index);
+            }
+        }
+        if (task == nullptr) {
+            // 停止时把剩下的任务做完再退
+            if (stop_.load(std::memory_order_acquire) && !HasWork()) break;
+            Park(self);
+            continue;
+        }
+        // 自己手上还有富余，叫醒一个兄弟来偷
+        if (!self.deque.Empty()) NotifyOne();
+        if (wait_histogram_ != nullptr) {
+            wait_histogram_->Record(MetricNowUs() - task->enqueue_us);
+        }
+        task->fn();
+        delete task;
+    }
+    IM_DEBUG("Worker thread %zu exiting.", index);
+}
+
+ThreadPool::Item *ThreadPool::FindTask(Worker &self, size_t index) {
+    Item *task = nullptr;
+    if (self.deque.Pop(task)) return task;
+    task = TakeInjected(self);
+    if (task != nullptr) return task;
+    return StealFromOthers(self, index);
+}
+
+ThreadPool::Item *ThreadPool::TakeInjected(Worker &self) {
+    if (inject_size_.load(std::memory_order_relaxed) == 0) return nullptr;
+    // 别的worker正在搬，就去偷它搬走的那批
+    if (inject_busy_.exchange(true, std::memory_order_acquire)) return nullptr;
+    // 按worker数平分，一次搬一批，减少争抢注入队列的次数
+    size_t pending = inject_size_.load(std::memory_order_relaxed);
+    size_t batch = std::min(kInjectBatch, pending / workers_.size() + 1);
+    Item *tasks[kInjectBatch];
+    size_t taken = 0;
+    while (taken < batch && inject_queue_.Pop(tasks[taken])) ++taken;
+    inject_busy_.store(false, std::memory_order_release);
+    if (taken == 0) return nullptr;
+    inject_size_.fetch_sub(taken, std::memory_order_relaxed);
+    // 本地队列从底部弹出，倒着压进去，自己按投递顺序执行
+    for (size_t i = taken - 1; i > 0; --i) self.deque.Push(tasks[i]);
+    return tasks[0];
+}
+
+ThreadPool::Item *ThreadPool::StealFromOthers(Worker &self, size_t index) {
+    size_t n = workers_.size();
+    if (n <= 1) return nullptr;
+    // 随机起点，避免所有空闲worker都盯着同一个受害者
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 7;
+    self.rng ^= self.rng << 17;
+    size_t start = self.rng % n;
+    Item *task = nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        size_t victim = (start + i) % n;
+        if (victim == index) continue;
+        if (workers_[victim]->deque.Steal(task)) return task;
+    }
+    return nullptr;
+}
+
+bool ThreadPool::HasWork() const {
+    if (inject_size_.load(std::memory_order_relaxed) > 0) return true;
+    for (const auto &worker : workers_) {
+        if (!worker->deque.Empty()) return true;
+    }
+    return false;
+}
+
+void ThreadPool::Park(Worker &self) {
+    self.parked.store(1, std::memory_order_relaxed);
+    sleepers_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // 登记成睡眠者之后再看一眼，投递者要么看到我们在睡，要么我们看到它的任务
+    if (HasWork() || stop_.load(std::memory_order_acquire)) {
+        // 自己撤销；抢输了说明已经有人叫过我们，计数由它减
+        if (self.parked.exchange(0, std::memory_order_acq_rel) == 1) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    while (self.parked.load(std::memory_order_acquire) == 1) {
+        FutexWait(&self.parked, 1);
+    }
+}
+
+void ThreadPool::NotifyOne() {
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+    for (auto &worker : workers_) {
+        uint32_t expected = 1;
+        if (worker->parked.load(std::memory_order_relaxed) == 1 &&
+            worker->parked.compare_exchange_strong(
+                expected, 0, std::memory_order_acq_rel)) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            FutexWake(&worker->parked, 1);
+            return;
+        }
+    }
+}
+
+void ThreadPool::NotifyAll() {
+    for (auto &worker : workers_) {
+        if (worker->parked.exchange(0, std::memory_order_acq_rel) == 1) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            FutexWake(&worker->parked, 1);
+        }
+    }
+}
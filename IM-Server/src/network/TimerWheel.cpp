@@ -0,0 +1,124 @@
+#include "network/TimerWheel.h"
+
+namespace {
+void ListInit(TimerListHead *head) {
+    head->prev = head;
+    head->next = head;
+}
+void ListAddTail(TimerListHead *head, TimerListHead *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+void ListDel(TimerListHead *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+// 把 from 整条链表搬到 to（to 原来为空），from 变空
+void ListSplice(TimerListHead *from, TimerListHead *to) {
+    ListInit(to);
+    if (from->next == from) return;
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    ListInit(from);
+}
+}  // namespace
+
+TimerWheel::TimerWheel() : current_(0) {
+    for (auto &slot : root_) ListInit(&slot);
+    for (auto &level : levels_) {
+        for (auto &slot : level) ListInit(&slot);
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    // 摘掉还挂着的节点，避免使用者析构时再去碰已经不存在的槽
+    auto clear = [](TimerListHead *slot) {
+        while (slot->next != slot) ListDel(slot->next);
+    };
+    for (auto &slot : root_) clear(&slot);
+    for (auto &level : levels_) {
+        for (auto &slot : level) clear(&slot);
+    }
+}
+
+void TimerWheel::Link(TimerNode *node) {
+    uint64_t expire = node->expire;
+    uint64_t delta = expire > current_ ? expire - current_ : 0;
+    if (delta < static_cast<uint64_t>(kRootSize)) {
+        // 已过期的放到当前槽，下一次 Advance 就执行
+        uint64_t tick = delta == 0 ? current_ : expire;
+        ListAddTail(&root_[tick & (kRootSize - 1)], node);
+        return;
+    }
+    for (int level = 0; level < kLevels - 1; ++level) {
+        int shift = kRootBits + level * kLevelBits;
+        if (delta < (1ULL << (shift + kLevelBits)) || level == kLevels - 2) {
+            uint64_t max_delta = (1ULL << (shift + kLevelBits)) - 1;
+            if (delta > max_delta) expire = current_ + max_delta;  // 超出量程就截断
+            ListAddTail(&levels_[level][(expire >> shift) & (kLevelSize - 1)],
+                        node);
+            return;
+        }
+    }
+}
+
+void TimerWheel::Add(TimerNode *node, uint64_t delay_ticks) {
+    if (node->IsLinked()) ListDel(node);
+    node->expire = current_ + delay_ticks;
+    Link(node);
+}
+
+void TimerWheel::Remove(TimerNode *node) {
+    if (node->IsLinked()) ListDel(node);
+}
+
+void TimerWheel::Refresh(TimerNode *node, uint64_t delay_ticks) {
+    uint64_t expire = current_ + delay_ticks;
+    if (node->IsLinked() && node->expire == expire) return;
+    Add(node, delay_ticks);
+}
+
+void TimerWheel::Cascade(int level, int index) {
+    TimerListHead list;
+    ListSplice(&levels_[level][index], &list);
+    while (list.next != &list) {
+        TimerNode *node = static_cast<TimerNode *>(list.next);
+        ListDel(node);
+        Link(node);
+    }
+}
+
+void TimerWheel::RunSlot(TimerListHead *slot) {
+    // 先整槽搬走，回调里增删其他定时器不会影响遍历
+    TimerListHead list;
+    ListSplice(slot, &list);
+    while (list.next != &list) {
+        TimerNode *node = static_cast<TimerNode *>(list.next);
+        ListDel(node);
+        if (node->callback) node->callback();
+    }
+}
+
+void TimerWheel::Advance(uint64_t ticks) {
+    while (ticks-- > 0) {
+        int index = static_cast<int>(current_ & (kRootSize - 1));
+        // 根层转完一圈，从上层依次下放一个槽
+        if (index == 0) {
+            for (int level = 0; level < kLevels - 1; ++level) {
+                int shift = kRootBits + level * kLevelBits;
+                int slot = static_cast<int>((current_ >> shift) &
+                                            (kLevelSize - 1));
+                Cascade(level, slot);
+                if (slot != 0) break;
+            }
+        }
+        RunSlot(&root_[index]);
+        ++current_;
+    }
+}
@@ -1,8 +1,15 @@
 #include "storage/MySQLManager.h"
 
-#include "common/json.hpp"
-using json = nlohmann::json;
-#include <spdlog/spdlog.h>
+#include "common/Logging.h"
+#include "common/Metrics.h"
+
+// 每种调用一个延迟直方图，从等连接锁开始算
+static Histogram *CallLatency(const char *op) {
+    return MetricsRegistry::GetInstance().GetHistogram(
+        "im_mysql_call_seconds", "MySQL call latency including lock wait",
+        std::string("op=\"") + op + "\"", 1e-6);
+}
+
 MySQLManager &MySQLManager::GetInstance() {
     static MySQLManager instance;
     return instance;
@@ -15,18 +22,18 @@ bool MySQLManager::Init(const std::string &host, const std::string &user,
                         const std::string &pwd, const std::string &db_name,
                         int port) {
     if (conn_ == nullptr) {
-        spdlog::error("MYSQL init failed!");
+        IM_ERROR("MYSQL init failed!");
         return false;
     }
     // 尝试连接
     if (mysql_real_connect(conn_, host.c_str(), user.c_str(), pwd.c_str(),
                            db_name.c_str(), port, nullptr, 0) == 0) {
-        spdlog::error("MYSQL connect error:{}", mysql_error(conn_));
+        IM_ERROR("MYSQL connect error:%s", mysql_error(conn_));
         return false;
     }
     // 设置字符集，防止中文乱码
     mysql_query(conn_, "SET NAMES utf8mb4");
-    spdlog::info("MySQL connected successfully to database: {}", db_name);
+    IM_INFO("MySQL connected successfully to database: %s", db_name.c_str());
     return true;
 }
 void MySQLManager::Close() {
@@ -39,6 +46,8 @@ void MySQLManager::Close() {
 // 模拟登录校验逻辑
 bool MySQLManager::CheckUser(const std::string &username,
                              const std::string &password) {
+    static Histogram *latency = CallLatency("check_user");
+    ScopedLatency timer(latency);
     std::lock_guard<std::mutex> lock(mutex_);
     // 防止SQL注入的简单处理
     char query[256];
@@ -46,7 +55,7 @@ bool MySQLManager::CheckUser(const std::string &username,
              "SELECT password FROM user WHERE username = '%s'",
              username.c_str());
     if (mysql_query(conn_, query)) {
-        spdlog::error("MYSQL query error: {}", mysql_error(conn_));
+        IM_ERROR("MYSQL query error: %s", mysql_error(conn_));
         return false;
     }
     MYSQL_RES *res = mysql_store_result(conn_);
@@ -68,6 +77,8 @@ bool MySQLManager::CheckUser(const std::string &username,
 bool MySQLManager::InsertOfflineMessage(const std::string &sender,
                                         const std::string &receiver,
                                         const std::string &content) {
+    static Histogram *latency = CallLatency("insert_offline");
+    ScopedLatency timer(latency);
     // 1、加锁 操作数据库
     std::lock_guard<std::mutex> lock(mutex_);
     // 2、准备sql语句
@@ -78,19 +89,21 @@ bool MySQLManager::InsertOfflineMessage(const std::string &sender,
              sender.c_str(), receiver.c_str(), content.c_str());
     // 4、执行sql语句
     if (mysql_query(conn_, query) != 0) {
-        spdlog::error("Failed to insert offline message: {}",
-                      mysql_error(conn_));
+        IM_ERROR("Failed to insert offline message: %s", mysql_error(conn_));
         return false;
     }
 
-    spdlog::info("Offline message saved! From {} or {}", sender, receiver);
+    IM_DEBUG("Offline message saved! From %s or %s", sender.c_str(),
+             receiver.c_str());
     return true;
 }
 
-std::vector<std::string> MySQLManager::GetAndClearOfflineMessages(
+std::vector<OfflineMessage> MySQLManager::GetAndClearOfflineMessages(
     const std::string &receiver) {
+    static Histogram *latency = CallLatency("get_offline");
+    ScopedLatency timer(latency);
     std::lock_guard<std::mutex> lock(mutex_);
-    std::vector<std::string> messages;
+    std::vector<OfflineMessage> messages;
 
     // 1. 拼凑 SELECT 语句
     char query[2048];
@@ -101,8 +114,7 @@ std::vector<std::string> MySQLManager::GetAndClearOfflineMessages(
 
     // 2. 执行 SELECT 语句
     if (mysql_query(conn_, query) != 0) {
-        spdlog::error("Failed to select offline message: {}",
-                      mysql_error(conn_));
+        IM_ERROR("Failed to select offline message: %s", mysql_error(conn_));
         return messages;
     }
     // 3. 获取结果集 (MYSQL_RES* res = mysql_store_result(conn_);)
@@ -114,12 +126,11 @@ std::vector<std::string> MySQLManager::GetAndClearOfflineMessages(
     // 4. 循环遍历结果集 (MYSQL_ROW row;)
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(res)) != nullptr) {
-        json msg_json;
-        msg_json["cmd"] = "push_chat";
-        msg_json["from"] = row[0] ? row[0] : "unknown";
-        msg_json["msg"] = row[1] ? row[1] : "";
-        msg_json["time"] = row[2] ? row[2] : "";
-        messages.push_back(msg_json.dump());
+        OfflineMessage msg;
+        msg.sender = row[0] ? row[0] : "unknown";
+        msg.content = row[1] ? row[1] : "";
+        msg.send_time = row[2] ? row[2] : "";
+        messages.push_back(std::move(msg));
     }
 
     // 5. 释放结果集 (mysql_free_result(res);)
@@ -130,11 +141,11 @@ std::vector<std::string> MySQLManager::GetAndClearOfflineMessages(
                  "DELETE FROM offline_message WHERE receiver = '%s'",
                  receiver.c_str());
         if (mysql_query(conn_, query) != 0) {
-            spdlog::error("Falied to clear offline message: {}",
-                          mysql_error(conn_));
+            IM_ERROR("Falied to clear offline message: %s",
+                     mysql_error(conn_));
         } else {
-            spdlog::info("cleard {} offline message for user '{}'",
-                         messages.size(), receiver);
+            IM_INFO("cleard %zu offline message for user '%s'",
+                    messages.size(), receiver.c_str());
         }
     }
     return messages;
@@ -142,11 +153,13 @@ std::vector<std::string> MySQLManager::GetAndClearOfflineMessages(
 
 std::unordered_map<int, std::unordered_set<std::string>>
 MySQLManager::GetAllGroupMembers() {
+    static Histogram *latency = CallLatency("load_groups");
+    ScopedLatency timer(latency);
     std::lock_guard<std::mutex> lock(mutex_);
     std::unordered_map<int, std::unordered_set<std::string>> result;
     const char *query = "SELECT group_id,user_id FROM group_member";
     if (mysql_query(conn_, query)) {
-        spdlog::error("Failed to select group members:{}.", mysql_error(conn_));
+        IM_ERROR("Failed to select group members:%s.", mysql_error(conn_));
         return result;
     }
     MYSQL_RES *res = mysql_store_result(conn_);
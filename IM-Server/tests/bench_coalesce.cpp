@@ -0,0 +1,115 @@
+// 发送合并基准：模拟一次登录的回包 + N 条离线消息，对比
+//   immediate: 每次 Send 立即写（旧做法，一包一次 sendmsg）
+//   coalesced: 本轮循环只入队，末尾 flush 一次
+// 在本机 TCP 连接上跑，统计每条消息的系统调用数和每批耗时。
+// 用法：bench_coalesce [rounds]
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network/Codec.h"
+#include "network/OutputQueue.h"
+
+using Clock = std::chrono::steady_clock;
+
+// 建一对本机 TCP 连接：返回 {写端, 读端}
+static bool MakeTcpPair(int fds[2]) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+        listen(listen_fd, 1) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr *>(&addr), &len) !=
+            0) {
+        close(listen_fd);
+        return false;
+    }
+    fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fds[1], reinterpret_cast<sockaddr *>(&addr), len) != 0) {
+        close(listen_fd);
+        return false;
+    }
+    fds[0] = accept(listen_fd, nullptr, nullptr);
+    close(listen_fd);
+    return fds[0] >= 0;
+}
+
+struct Result {
+    double calls_per_msg;
+    double us_per_burst;
+};
+
+static Result Run(size_t offline, int rounds, bool coalesced) {
+    int fds[2];
+    if (!MakeTcpPair(fds)) {
+        std::perror("tcp pair");
+        std::exit(1);
+    }
+    // 对端一直读空，不让内核缓冲区成为瓶颈
+    std::thread reader([&] {
+        char buf[65536];
+        while (read(fds[1], buf, sizeof(buf)) > 0) {
+        }
+    });
+
+    PacketPtr resp = std::make_shared<const std::string>(Codec::PackMessage(
+        1, "{\"cmd\":\"login_resp\",\"code\":200,\"msg\":\"Login Success!\"}"));
+    PacketPtr push = std::make_shared<const std::string>(Codec::PackMessage(
+        2, "{\"cmd\":\"push_chat\",\"from\":\"user1\",\"msg\":\"offline "
+           "message\",\"time\":\"2024-01-01 00:00:00\"}"));
+    OutputQueue queue;
+    WriteStats stats;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        if (coalesced) {
+            queue.Push(resp);
+            for (size_t i = 0; i < offline; ++i) queue.Push(push);
+            queue.WriteTo(fds[0], CorkMode::kNone, &stats);
+        } else {
+            queue.Push(resp);
+            queue.WriteTo(fds[0], CorkMode::kNone, &stats);
+            for (size_t i = 0; i < offline; ++i) {
+                queue.Push(push);
+                queue.WriteTo(fds[0], CorkMode::kNone, &stats);
+            }
+        }
+    }
+    double us = std::chrono::duration<double, std::micro>(Clock::now() -
+                                                          start)
+                    .count();
+    shutdown(fds[0], SHUT_WR);
+    reader.join();
+    close(fds[0]);
+    close(fds[1]);
+    double messages = static_cast<double>(rounds) * (offline + 1);
+    return Result{stats.calls / messages, us / rounds};
+}
+
+int main(int argc, char **argv) {
+    int rounds = 20000;
+    if (argc > 1) rounds = std::atoi(argv[1]);
+    const size_t offline_counts[] = {0, 4, 16, 64};
+    std::printf("%-8s %14s %14s %14s %14s\n", "offline", "imm(call/msg)",
+                "coal(call/msg)", "imm(us/burst)", "coal(us/burst)");
+    for (size_t offline : offline_counts) {
+        int n = static_cast<int>(rounds / (offline + 1)) + 1;
+        Result before = Run(offline, n, false);
+        Result after = Run(offline, n, true);
+        std::printf("%-8zu %14.3f %14.3f %14.2f %14.2f\n", offline,
+                    before.calls_per_msg, after.calls_per_msg,
+                    before.us_per_burst, after.us_per_burst);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// 群聊裂变开销基准：对比“每个成员单独序列化”与“序列化一次、共享帧入队”
+// 两种做法在不同群规模下的耗时。只依赖 Codec / OutputQueue，不需要数据库。
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/json.hpp"
+#include "network/Codec.h"
+#include "network/OutputQueue.h"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+static json BuildPush(int group_id, const std::string &content) {
+    json push_json;
+    push_json["cmd"] = "push_group_chat";
+    push_json["group_id"] = group_id;
+    push_json["from"] = "sender";
+    push_json["msg"] = content;
+    return push_json;
+}
+
+// 旧做法：每个成员一份 json、一次 dump、一次打包
+static void FanoutPerMember(std::vector<OutputQueue> &queues,
+                            const std::string &content) {
+    for (auto &queue : queues) {
+        json push_json = BuildPush(1, content);
+        queue.Push(std::make_shared<const std::string>(
+            Codec::PackMessage(2, push_json.dump())));
+    }
+}
+
+// 新做法：编码一次，所有成员共享同一个帧
+static void FanoutShared(std::vector<OutputQueue> &queues,
+                         const std::string &content) {
+    PacketPtr packet = std::make_shared<const std::string>(
+        Codec::PackMessage(2, BuildPush(1, content).dump()));
+    for (auto &queue : queues) {
+        queue.Push(packet);
+    }
+}
+
+template <typename Fn>
+static double MeasureUs(size_t group_size, int rounds, Fn fn) {
+    std::string content(128, 'x');
+    std::vector<OutputQueue> queues(group_size);
+    auto start = Clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        fn(queues, content);
+        for (auto &queue : queues) queue.Clear();
+    }
+    auto cost = std::chrono::duration<double, std::micro>(Clock::now() - start);
+    return cost.count() / rounds;
+}
+
+int main() {
+    const size_t sizes[] = {10, 100, 1000, 5000};
+    std::printf("%-10s %16s %16s %8s\n", "members", "per_member(us)",
+                "shared(us)", "speedup");
+    for (size_t size : sizes) {
+        int rounds = static_cast<int>(200000 / size) + 1;
+        double old_us = MeasureUs(size, rounds, FanoutPerMember);
+        double new_us = MeasureUs(size, rounds, FanoutShared);
+        std::printf("%-10zu %16.2f %16.2f %7.1fx\n", size, old_us, new_us,
+                    old_us / new_us);
+    }
+    return 0;
+}
@@ -0,0 +1,387 @@
+// Poller 后端基准：同一个 echo 服务分别跑在 epoll（水平/边缘/单次触发）和
+// io_uring 上，客户端开 N 条本机长连接，每条连接同时只有一个 16 字节的 ping 在路上，
+// 收到 pong 马上发下一个，统计 QPS、往返延迟分位数，
+// 以及服务端每条消息摊到的改注册次数（ctl/msg）和 loop 醒来次数（polls/msg）。
+// 客户端固定用 epoll，几轮只有服务端的 Poller、触发方式和 socket 预设不同。
+// low_latency 预设和 Config 里的一致：TCP_QUICKACK、SO_BUSY_POLL 加 loop 自适应忙轮询，
+// 连接数少时（例如 bench_pingpong 1）更能看出 p99 的差别。
+// 用法：bench_pingpong [connections] [seconds] [io_loops]
+//   连接数受 RLIMIT_NOFILE 限制（一条连接两端各占一个fd），不够时自动缩小。
+//   客户端每 2 万条连接换一个源地址（127.0.0.2、127.0.0.3...），避开单个源IP的临时端口上限。
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/Logging.h"
+#include "network/Channel.h"
+#include "network/EventLoop.h"
+#include "network/EventLoopThread.h"
+#include "network/SocketOptions.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t kPingSize = 16;
+static const size_t kConnsPerSourceIp = 20000;
+
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+}
+
+// 服务端 socket 预设
+struct Preset {
+    const char *name;
+    SocketOptions socket;
+    int loop_spin_us;
+};
+
+static Preset DefaultPreset() { return {"default", SocketOptions(), 0}; }
+
+static Preset LowLatencyPreset() {
+    Preset preset = {"low_lat", SocketOptions(), 100};
+    preset.socket.quick_ack = true;
+    preset.socket.busy_poll_us = 50;
+    return preset;
+}
+
+// 服务端一条连接：读多少回多少，写不完的等可写
+struct EchoConn {
+    EchoConn(EventLoop *loop, int fd) : fd(fd), channel(loop, fd) {}
+    int fd;
+    Channel channel;
+    bool quick_ack = false;
+    std::string pending;
+    bool closed = false;
+};
+
+static void EchoHandle(EchoConn *conn, uint32_t revents) {
+    if (conn->closed) return;
+    bool edge = conn->channel.Mode() == TriggerMode::kEdge;
+    if (revents & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        // 边缘触发要读到 EAGAIN
+        while (true) {
+            char buf[4096];
+            ssize_t n = read(conn->fd, buf, sizeof(buf));
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                // 对象留到基准结束统一释放，本批事件里的指针一直有效
+                conn->channel.Remove();
+                close(conn->fd);
+                conn->closed = true;
+                return;
+            }
+            if (n > 0) conn->pending.append(buf, n);
+            if (!edge || n < static_cast<ssize_t>(sizeof(buf))) break;
+        }
+        if (conn->quick_ack) RearmQuickAck(conn->fd);
+    }
+    if (!conn->pending.empty()) {
+        ssize_t n = write(conn->fd, conn->pending.data(), conn->pending.size());
+        if (n > 0) conn->pending.erase(0, n);
+        // 边缘触发一直关注可写，不改注册
+        if (edge) return;
+        if (!conn->pending.empty() && !conn->channel.IsWriting()) {
+            conn->channel.EnableWriting();
+        } else if (conn->pending.empty() && conn->channel.IsWriting()) {
+            conn->channel.DisableWriting();
+        }
+    }
+}
+
+class EchoServer {
+public:
+    EchoServer(const std::string &poller, TriggerMode mode,
+               const Preset &preset, size_t io_loops)
+        : mode_(mode), socket_(preset.socket) {
+        for (size_t i = 0; i < std::max<size_t>(1, io_loops); ++i) {
+            threads_.emplace_back(new EventLoopThread(poller));
+            loops_.push_back(threads_.back()->StartLoop());
+            loops_.back()->SetBusyPoll(preset.loop_spin_us);
+        }
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+            listen(listen_fd_, SOMAXCONN) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr),
+                        &len) != 0) {
+            std::perror("listen");
+            std::exit(1);
+        }
+        port_ = ntohs(addr.sin_port);
+        EventLoop *accept_loop = loops_[0];
+        listen_channel_.reset(new Channel(accept_loop, listen_fd_));
+        listen_channel_->SetEventCallback([this](uint32_t) { Accept(); });
+        Channel *channel = listen_channel_.get();
+        accept_loop->RunInLoop([channel] { channel->EnableReading(); });
+    }
+
+    ~EchoServer() {
+        EventLoop *accept_loop = loops_[0];
+        Channel *channel = listen_channel_.get();
+        accept_loop->RunInLoop([channel] { channel->Remove(); });
+        // 先停掉所有loop线程，再关还没断开的连接
+        threads_.clear();
+        for (auto &conn : conns_) {
+            if (!conn->closed) close(conn->fd);
+        }
+        close(listen_fd_);
+    }
+
+    uint16_t Port() const { return port_; }
+    // 实际用上的后端（io_uring 不可用时会退回 epoll）
+    const char *PollerName() const { return loops_[0]->PollerName(); }
+    // 所有loop的 改注册次数 / 醒来次数 之和
+    void Counters(uint64_t *ctl_calls, uint64_t *polls) const {
+        *ctl_calls = *polls = 0;
+        for (EventLoop *loop : loops_) {
+            *ctl_calls += loop->GetIoStats().ctl_calls.load();
+            *polls += loop->GetIoStats().polls.load();
+        }
+    }
+
+private:
+    void Accept() {
+        while (true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            ApplySocketOptions(fd, socket_);
+            EventLoop *loop = loops_[next_++ % loops_.size()];
+            conns_.emplace_back(new EchoConn(loop, fd));
+            EchoConn *conn = conns_.back().get();
+            conn->quick_ack = socket_.quick_ack;
+            conn->channel.SetTriggerMode(mode_);
+            conn->channel.SetEventCallback(
+                [conn](uint32_t revents) { EchoHandle(conn, revents); });
+            loop->RunInLoop([conn] {
+                if (conn->channel.Mode() == TriggerMode::kEdge) {
+                    conn->channel.EnableReadWrite();
+                } else {
+                    conn->channel.EnableReading();
+                }
+            });
+        }
+    }
+
+    TriggerMode mode_;
+    SocketOptions socket_;
+    std::vector<std::unique_ptr<EventLoopThread>> threads_;
+    std::vector<EventLoop *> loops_;
+    int listen_fd_;
+    uint16_t port_;
+    std::unique_ptr<Channel> listen_channel_;
+    // 只有accept线程追加，析构时loop线程都已退出
+    std::vector<std::unique_ptr<EchoConn>> conns_;
+    size_t next_ = 0;
+};
+
+struct ClientConn {
+    int fd;
+    size_t received = 0;
+    char buf[kPingSize];
+};
+
+static bool SendPing(ClientConn &conn) {
+    char msg[kPingSize] = {};
+    int64_t now = NowNs();
+    memcpy(msg, &now, sizeof(now));
+    return write(conn.fd, msg, sizeof(msg)) == static_cast<ssize_t>(kPingSize);
+}
+
+struct Result {
+    const char *poller;
+    size_t conns;
+    double qps;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    double ctl_per_msg;
+    double polls_per_msg;
+};
+
+static int ConnectOne(uint16_t port, size_t index) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in src = {};
+    src.sin_family = AF_INET;
+    src.sin_addr.s_addr =
+        htonl(INADDR_LOOPBACK + 1 + index / kConnsPerSourceIp);
+    int on = 1;
+    setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&src), sizeof(src)) != 0 ||
+        connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static Result Run(const std::string &poller, TriggerMode mode,
+                  const Preset &preset, size_t num_conns, int seconds,
+                  size_t io_loops) {
+    EchoServer server(poller, mode, preset, io_loops);
+    std::vector<ClientConn> conns;
+    conns.reserve(num_conns);
+    for (size_t i = 0; i < num_conns; ++i) {
+        int fd = ConnectOne(server.Port(), i);
+        if (fd < 0) {
+            std::fprintf(stderr, "connect #%zu failed: %s\n", i,
+                         strerror(errno));
+            break;
+        }
+        ClientConn conn = {};
+        conn.fd = fd;
+        conns.push_back(conn);
+    }
+    int epfd = epoll_create1(0);
+    for (size_t i = 0; i < conns.size(); ++i) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+        SendPing(conns[i]);
+    }
+
+    std::vector<uint32_t> samples;  // 往返延迟，单位 100ns
+    samples.reserve(1 << 20);
+    std::vector<struct epoll_event> events(1024);
+    uint64_t ctl_start, polls_start;
+    server.Counters(&ctl_start, &polls_start);
+    auto deadline = Clock::now() + std::chrono::seconds(seconds);
+    auto start = Clock::now();
+    size_t completed = 0;
+    while (Clock::now() < deadline) {
+        int n = epoll_wait(epfd, events.data(), events.size(), 100);
+        for (int i = 0; i < n; ++i) {
+            ClientConn &conn = conns[events[i].data.u64];
+            ssize_t r = read(conn.fd, conn.buf + conn.received,
+                             kPingSize - conn.received);
+            if (r <= 0) continue;
+            conn.received += r;
+            if (conn.received < kPingSize) continue;
+            conn.received = 0;
+            int64_t sent;
+            memcpy(&sent, conn.buf, sizeof(sent));
+            samples.push_back(static_cast<uint32_t>((NowNs() - sent) / 100));
+            ++completed;
+            SendPing(conn);
+        }
+    }
+    double elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    uint64_t ctl_end, polls_end;
+    server.Counters(&ctl_end, &polls_end);
+    close(epfd);
+    for (ClientConn &conn : conns) close(conn.fd);
+
+    Result result = {server.PollerName(), conns.size(), completed / elapsed,
+                     0, 0, 0, 0, 0};
+    if (completed > 0) {
+        result.ctl_per_msg =
+            static_cast<double>(ctl_end - ctl_start) / completed;
+        result.polls_per_msg =
+            static_cast<double>(polls_end - polls_start) / completed;
+    }
+    if (!samples.empty()) {
+        auto pick = [&samples](double q) {
+            size_t k = static_cast<size_t>(q * (samples.size() - 1));
+            std::nth_element(samples.begin(), samples.begin() + k,
+                             samples.end());
+            return samples[k] / 10.0;
+        };
+        result.p50_us = pick(0.50);
+        result.p99_us = pick(0.99);
+        result.p999_us = pick(0.999);
+    }
+    return result;
+}
+
+// 尽量把fd上限提到硬上限，返回能支撑的连接数
+static size_t MaxConnections() {
+    struct rlimit limit;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    return limit.rlim_cur > 256 ? (limit.rlim_cur - 256) / 2 : 0;
+}
+
+int main(int argc, char **argv) {
+    size_t num_conns = 10000;
+    int seconds = 5;
+    size_t io_loops = 1;
+    if (argc > 1) num_conns = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) seconds = std::atoi(argv[2]);
+    if (argc > 3) io_loops = std::strtoul(argv[3], nullptr, 10);
+    size_t max_conns = MaxConnections();
+    if (num_conns > max_conns) {
+        std::printf("RLIMIT_NOFILE only allows %zu connections (asked %zu)\n",
+                    max_conns, num_conns);
+        num_conns = max_conns;
+    }
+    ServerLogOptions log_options;
+    log_options.base = "bench_pingpong";
+    log_options.level = "warn";
+    ServerLog::Init(log_options);
+
+    std::printf("connections=%zu seconds=%d io_loops=%zu\n", num_conns,
+                seconds, io_loops);
+    // 客户端自己占一个核，剩下的不够每个loop一个时忙轮询是在抢客户端的CPU
+    if (std::thread::hardware_concurrency() < io_loops + 2) {
+        std::printf("note: %u CPUs, low_lat loop spin competes with the "
+                    "client (TcpServer turns it off in this case)\n",
+                    std::thread::hardware_concurrency());
+    }
+    std::printf("%-9s %-8s %-8s %8s %10s %10s %10s %10s %8s %10s\n",
+                "poller", "mode", "preset", "conns", "qps", "p50(us)", "p99(us)", "p999(us)",
+                "ctl/msg", "polls/msg");
+    struct Case {
+        const char *poller;
+        TriggerMode mode;
+        Preset preset;
+    };
+    const Case cases[] = {
+        {"epoll", TriggerMode::kLevel, DefaultPreset()},
+        {"epoll", TriggerMode::kEdge, DefaultPreset()},
+        {"epoll", TriggerMode::kOneShot, DefaultPreset()},
+        {"io_uring", TriggerMode::kLevel, DefaultPreset()},
+        {"epoll", TriggerMode::kLevel, LowLatencyPreset()},
+        {"io_uring", TriggerMode::kLevel, LowLatencyPreset()},
+    };
+    for (const Case &c : cases) {
+        Result r =
+            Run(c.poller, c.mode, c.preset, num_conns, seconds, io_loops);
+        std::printf(
+            "%-9s %-8s %-8s %8zu %10.0f %10.1f %10.1f %10.1f %8.3f %10.3f\n",
+            r.poller, TriggerModeName(c.mode), c.preset.name, r.conns, r.qps,
+            r.p50_us, r.p99_us, r.p999_us, r.ctl_per_msg, r.polls_per_msg);
+    }
+    ServerLog::Shutdown();
+    return 0;
+}
@@ -0,0 +1,99 @@
+// 连接对象分配基准：模拟重连风暴，accept 线程不停建“连接”，
+// 另一个线程（loop/工作线程）析构，对比
+//   malloc: make_shared + vector 缓冲区 + 默认分配器的发送队列（旧做法）
+//   pooled: allocate_shared(PoolAllocator) + BlockPool 缓冲区 + 池化发送队列
+// 用法：bench_pool [connections]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/BlockPool.h"
+#include "network/Buffer.h"
+#include "network/OutputQueue.h"
+
+using Clock = std::chrono::steady_clock;
+
+// 旧连接的主要成员：vector 缓冲区 + deque 发送队列 + 单独分配的 Strand 等
+struct LegacyConn {
+    std::vector<char> read_buffer = std::vector<char>(1032);
+    std::deque<PacketPtr> output;
+    std::unique_ptr<char[]> channel{new char[64]};
+    std::shared_ptr<int> strand = std::make_shared<int>(0);
+    char other[256];
+};
+
+struct PooledConn {
+    Buffer read_buffer;
+    OutputQueue output;
+    char channel[64];
+    std::shared_ptr<int> strand =
+        std::allocate_shared<int>(PoolAllocator<int>(), 0);
+    char other[256];
+};
+
+// 生产者建对象交给消费者线程析构，批量交接模拟 RemoveConnection
+template <typename Make>
+static double Churn(size_t total, Make make) {
+    using Ptr = decltype(make());
+    std::mutex mutex;
+    std::vector<Ptr> handoff;
+    std::atomic<bool> done(false);
+    std::thread destroyer([&] {
+        std::vector<Ptr> batch;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch.swap(handoff);
+            }
+            if (batch.empty()) {
+                if (done.load()) break;
+                std::this_thread::yield();
+                continue;
+            }
+            batch.clear();
+        }
+    });
+    auto start = Clock::now();
+    std::vector<Ptr> local;
+    for (size_t i = 0; i < total; ++i) {
+        local.push_back(make());
+        if (local.size() == 64) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &p : local) handoff.push_back(std::move(p));
+            local.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &p : local) handoff.push_back(std::move(p));
+    }
+    done = true;
+    destroyer.join();
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    return total / sec;
+}
+
+int main(int argc, char **argv) {
+    size_t total = 1000000;
+    if (argc > 1) total = std::strtoul(argv[1], nullptr, 10);
+    double legacy = Churn(total, [] { return std::make_shared<LegacyConn>(); });
+    double pooled = Churn(total, [] {
+        return std::allocate_shared<PooledConn>(PoolAllocator<PooledConn>());
+    });
+    BlockPool::Stats stats = BlockPool::GetStats();
+    std::printf("%-8s %16s %16s %8s\n", "conns", "malloc(conn/s)",
+                "pooled(conn/s)", "speedup");
+    std::printf("%-8zu %16.0f %16.0f %7.2fx\n", total, legacy, pooled,
+                pooled / legacy);
+    std::printf("pool hits %llu, misses %llu, refills %llu\n",
+                static_cast<unsigned long long>(stats.hits),
+                static_cast<unsigned long long>(stats.misses),
+                static_cast<unsigned long long>(stats.refills));
+    return 0;
+}
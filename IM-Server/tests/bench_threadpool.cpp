@@ -0,0 +1,150 @@
+// 线程池吞吐基准：对比旧的“单队列 + 一把锁 + 条件变量”线程池和工作窃取线程池。
+//   external: 若干个外部线程（模拟IO loop）往池里投递小任务
+//   nested:   池内任务再派生子任务（工作窃取的本地队列优势所在）
+// 用法：bench_threadpool [workers] [tasks_per_producer]
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "network/ThreadPool.h"
+
+using Clock = std::chrono::steady_clock;
+
+// 旧实现原样保留作对照
+class LegacyThreadPool {
+public:
+    explicit LegacyThreadPool(size_t num_threads) : stop_(false) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex_);
+                        condition_.wait(lock, [this] {
+                            return stop_ || !tasks_.empty();
+                        });
+                        if (stop_ && tasks_.empty()) return;
+                        task = std::move(tasks_.front());
+                        tasks_.pop();
+                    }
+                    if (task) task();
+                }
+            });
+        }
+    }
+    ~LegacyThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (std::thread &worker : workers_) worker.join();
+    }
+    void Enqueue(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            tasks_.push(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex queue_mutex_;
+    std::condition_variable condition_;
+    bool stop_;
+};
+
+// 模拟一次很轻的业务处理
+static inline void SmallWork(std::atomic<uint64_t> &sink) {
+    uint64_t x = 1;
+    for (int i = 0; i < 64; ++i) x = x * 6364136223846793005ull + 1;
+    sink.fetch_add(x & 1, std::memory_order_relaxed);
+}
+
+static void WaitDone(std::atomic<size_t> &done, size_t expected) {
+    while (done.load(std::memory_order_acquire) < expected) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename Pool>
+static double BenchExternal(Pool &pool, size_t producers, size_t per_producer) {
+    std::atomic<size_t> done(0);
+    std::atomic<uint64_t> sink(0);
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (size_t i = 0; i < per_producer; ++i) {
+                pool.Enqueue([&] {
+                    SmallWork(sink);
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    WaitDone(done, producers * per_producer);
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    return producers * per_producer / sec;
+}
+
+template <typename Pool>
+static double BenchNested(Pool &pool, size_t roots, size_t fanout) {
+    std::atomic<size_t> done(0);
+    std::atomic<uint64_t> sink(0);
+    auto start = Clock::now();
+    for (size_t r = 0; r < roots; ++r) {
+        pool.Enqueue([&] {
+            for (size_t c = 0; c < fanout; ++c) {
+                pool.Enqueue([&] {
+                    SmallWork(sink);
+                    done.fetch_add(1, std::memory_order_release);
+                });
+            }
+        });
+    }
+    WaitDone(done, roots * fanout);
+    double sec = std::chrono::duration<double>(Clock::now() - start).count();
+    return roots * fanout / sec;
+}
+
+int main(int argc, char **argv) {
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    size_t per_producer = 200000;
+    if (argc > 1) workers = std::strtoul(argv[1], nullptr, 10);
+    if (argc > 2) per_producer = std::strtoul(argv[2], nullptr, 10);
+    const size_t producers = 4;  // 相当于4个IO loop
+    const size_t roots = per_producer / 16;
+    const size_t fanout = 64;
+
+    std::printf("workers=%zu producers=%zu tasks/producer=%zu\n", workers,
+                producers, per_producer);
+    std::printf("%-10s %18s %18s %8s\n", "case", "legacy(task/s)",
+                "stealing(task/s)", "speedup");
+    double legacy_ext, steal_ext, legacy_nested, steal_nested;
+    {
+        LegacyThreadPool pool(workers);
+        legacy_ext = BenchExternal(pool, producers, per_producer);
+        legacy_nested = BenchNested(pool, roots, fanout);
+    }
+    {
+        ThreadPool pool(workers);
+        steal_ext = BenchExternal(pool, producers, per_producer);
+        steal_nested = BenchNested(pool, roots, fanout);
+    }
+    std::printf("%-10s %18.0f %18.0f %7.2fx\n", "external", legacy_ext,
+                steal_ext, steal_ext / legacy_ext);
+    std::printf("%-10s %18.0f %18.0f %7.2fx\n", "nested", legacy_nested,
+                steal_nested, steal_nested / legacy_nested);
+    return 0;
+}
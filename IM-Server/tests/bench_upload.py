@@ -0,0 +1,48 @@
+import socket
+import struct
+import json
+import time
+import sys
+
+# 大块上传压测：把 total_mb 的数据切成 frame_kb 大小的 Ping 包连续灌给服务器，
+# 统计吞吐。配合下面的命令看服务端每 MB 的读系统调用次数：
+#   strace -c -f -e trace=read,readv -p $(pidof im_server)
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("server closed")
+        data += chunk
+    return data
+
+def run(total_mb=64, frame_kb=64):
+    client = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    client.connect(('127.0.0.1', 8080))
+    frame = pack_msg(3, {"cmd": "ping", "pad": "x" * (frame_kb * 1024)})
+    count = max(1, total_mb * 1024 * 1024 // len(frame))
+    start = time.time()
+    batch = frame * 16
+    sent = 0
+    while sent < count:
+        n = min(16, count - sent)
+        client.sendall(batch if n == 16 else frame * n)
+        sent += n
+        # 收掉对应的 Pong，避免服务端写缓冲堆积
+        for _ in range(n):
+            _, body_len = struct.unpack('!II', recv_exact(client, 8))
+            recv_exact(client, body_len)
+    cost = time.time() - start
+    mb = count * len(frame) / 1024 / 1024
+    print(f"📦 上传 {mb:.1f} MB, {count} 个包, 耗时 {cost:.2f}s, {mb / cost:.1f} MB/s")
+    client.close()
+
+if __name__ == '__main__':
+    total = int(sys.argv[1]) if len(sys.argv) > 1 else 64
+    run(total_mb=total)
@@ -0,0 +1,86 @@
+import socket
+import struct
+import json
+import time
+import sys
+
+# 重连风暴：user1 登录后持续 ping，同时一口气建 N 条新连接，每条发一个 ping。
+# 要求：user1 的 ping 一直有回应；新连接要么拿到 pong，要么被服务端立刻关掉
+# （fd 用完时 Acceptor 会让出预留fd接了就关），不能一直挂着没人管。
+#   服务端用 prlimit --nofile=128 启动可以看到多出来的连接被关掉；
+#   配置 acceptor.rate 后新连接被限速接入，可以把 STORM_TIMEOUT 调大观察
+STORM_TIMEOUT = 15
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, json.loads(recv_exact(sock, body_len).decode('utf-8'))
+
+def ping_rtt(sock):
+    start = time.time()
+    sock.sendall(pack_msg(3, {"cmd": "ping"}))
+    msg_type, _ = recv_msg(sock)
+    assert msg_type == 4
+    return (time.time() - start) * 1000
+
+def run_client(count=500):
+    user = socket.create_connection(('127.0.0.1', 8080))
+    user.settimeout(5)
+    user.sendall(pack_msg(1, {"cmd": "login", "username": "user1", "password": "123456"}))
+    print("[user1] 登录回包 ->", recv_msg(user))
+    print(f"风暴前 user1 ping {ping_rtt(user):.2f}ms")
+
+    print(f"\n--- 一口气建 {count} 条连接 ---")
+    storm = []
+    refused = 0
+    for _ in range(count):
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.settimeout(STORM_TIMEOUT)
+        try:
+            s.connect(('127.0.0.1', 8080))
+            s.sendall(pack_msg(3, {"cmd": "ping"}))
+            storm.append(s)
+        except OSError:
+            refused += 1
+            s.close()
+
+    rtts = [ping_rtt(user) for _ in range(20)]
+    print(f"风暴中 user1 ping 最大 {max(rtts):.2f}ms")
+
+    served = closed = 0
+    start = time.time()
+    for s in storm:
+        try:
+            msg_type, _ = recv_msg(s)
+            assert msg_type == 4
+            served += 1
+        except (ConnectionError, ConnectionResetError):
+            closed += 1
+        except socket.timeout:
+            print("有连接超时没有回应")
+            sys.exit(1)
+    print(f"拿到 pong {served} 条，被服务端关掉 {closed} 条，"
+          f"建连失败 {refused} 条，用时 {time.time() - start:.2f}s")
+    assert served + closed == len(storm)
+
+    for s in storm:
+        s.close()
+    print(f"风暴后 user1 ping {ping_rtt(user):.2f}ms")
+    user.close()
+    print("\n接入风暴测试通过")
+
+if __name__ == '__main__':
+    run_client()
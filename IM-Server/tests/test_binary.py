@@ -0,0 +1,176 @@
+import socket
+import struct
+import json
+
+# 二进制包体：msg_type 带 1<<30 标志位，包体是一串 TLV 字段
+#   varint(field << 3 | wire) + 值；wire 0 是 varint，2 是 varint 长度 + 字节
+BINARY_FLAG = 1 << 30
+FLAG_MASK = 0xFF000000
+F_CMD, F_CODE, F_MSG, F_USERNAME, F_PASSWORD, F_TO, F_FROM, F_GROUP_ID, \
+    F_USERS, F_TIME, F_STATUS, F_BINARY = range(1, 13)
+CMD_LOGIN, CMD_LOGIN_RESP, CMD_CHAT, CMD_GROUP_CHAT, CMD_PUSH_CHAT, \
+    CMD_PUSH_GROUP_CHAT, CMD_PRESENCE, CMD_PRESENCE_RESP = range(1, 9)
+
+def put_varint(value):
+    out = b''
+    while value >= 0x80:
+        out += bytes([(value & 0x7F) | 0x80])
+        value >>= 7
+    return out + bytes([value])
+
+def get_varint(data, pos):
+    value, shift = 0, 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte & 0x80 == 0:
+            return value, pos
+        shift += 7
+
+def encode(fields):
+    out = b''
+    for tag, value in fields:
+        if isinstance(value, int):
+            out += put_varint(tag << 3) + put_varint(value)
+        else:
+            if isinstance(value, str):
+                value = value.encode('utf-8')
+            out += put_varint(tag << 3 | 2) + put_varint(len(value)) + value
+    return out
+
+def decode(body):
+    fields, pos = [], 0
+    while pos < len(body):
+        key, pos = get_varint(body, pos)
+        value, pos = get_varint(body, pos)
+        if key & 7 == 2:
+            value, pos = body[pos:pos + value], pos + value
+        fields.append((key >> 3, value))
+    return fields
+
+def pack_bin(msg_type, fields):
+    body = encode(fields)
+    return struct.pack('!II', msg_type | BINARY_FLAG, len(body)) + body
+
+def pack_json(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    return struct.pack('!II', msg_type, len(body)) + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+# 按标志位自动识别格式：二进制返回 dict(tag -> 值)，JSON 返回 dict
+def recv_msg(sock):
+    raw_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    body = recv_exact(sock, body_len)
+    msg_type = raw_type & ~FLAG_MASK
+    if raw_type & BINARY_FLAG:
+        return msg_type, 'binary', dict(decode(body))
+    return msg_type, 'json', json.loads(body.decode('utf-8'))
+
+def connect():
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.connect(('127.0.0.1', 8080))
+    return sock
+
+def run_client():
+    # user1 用二进制登录，user2 用 JSON 登录但声明推送要二进制，user3 纯 JSON
+    user1 = connect()
+    user1.sendall(pack_bin(1, [(F_CMD, CMD_LOGIN), (F_USERNAME, "user1"), (F_PASSWORD, "123456")]))
+    msg_type, fmt, resp = recv_msg(user1)
+    print("[user1] 登录回包 ->", msg_type, fmt, resp)
+    assert fmt == 'binary' and resp[F_CMD] == CMD_LOGIN_RESP and resp[F_CODE] == 200
+
+    user2 = connect()
+    user2.sendall(pack_json(1, {"cmd": "login", "username": "user2", "password": "123456", "binary": True}))
+    msg_type, fmt, resp = recv_msg(user2)
+    print("[user2] 登录回包 ->", msg_type, fmt, resp)
+    assert fmt == 'json' and resp["code"] == 200
+
+    user3 = connect()
+    user3.sendall(pack_json(1, {"cmd": "login", "username": "user3", "password": "123456"}))
+    msg_type, fmt, resp = recv_msg(user3)
+    print("[user3] 登录回包 ->", msg_type, fmt, resp)
+    assert fmt == 'json' and resp["code"] == 200
+
+    # 心跳：二进制 ping 回空包体的二进制 pong
+    user1.sendall(struct.pack('!II', 3 | BINARY_FLAG, 0))
+    msg_type, fmt, resp = recv_msg(user1)
+    print("[user1] pong ->", msg_type, fmt, resp)
+    assert msg_type == 4 and fmt == 'binary' and resp == {}
+
+    # 单聊：推送按接收方的格式编码
+    print("\n--- user1 -> user2 / user3 单聊 ---")
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_CHAT), (F_TO, "user2"), (F_MSG, "你好 user2")]))
+    msg_type, fmt, push = recv_msg(user2)
+    print("[user2] 收到 ->", fmt, push)
+    assert fmt == 'binary' and push[F_CMD] == CMD_PUSH_CHAT
+    assert push[F_FROM] == b"user1" and push[F_MSG].decode('utf-8') == "你好 user2"
+    msg_type, fmt, resp = recv_msg(user1)
+    assert fmt == 'binary' and resp[F_CODE] == 200
+
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_CHAT), (F_TO, "user3"), (F_MSG, "hi user3")]))
+    msg_type, fmt, push = recv_msg(user3)
+    print("[user3] 收到 ->", fmt, push)
+    assert fmt == 'json' and push == {"cmd": "push_chat", "from": "user1", "msg": "hi user3"}
+    recv_msg(user1)
+
+    # 群聊：两种格式各编码一次
+    print("\n--- user1 群聊 ---")
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_GROUP_CHAT), (F_GROUP_ID, 1), (F_MSG, "group hi")]))
+    _, fmt, push = recv_msg(user2)
+    print("[user2] 收到 ->", fmt, push)
+    assert fmt == 'binary' and push[F_CMD] == CMD_PUSH_GROUP_CHAT and push[F_GROUP_ID] == 1
+    _, fmt, push = recv_msg(user3)
+    print("[user3] 收到 ->", fmt, push)
+    assert fmt == 'json' and push["cmd"] == "push_group_chat" and push["msg"] == "group hi"
+    _, fmt, resp = recv_msg(user1)
+    print("[user1] 回执 ->", fmt, resp)
+    assert resp[F_CODE] == 200
+
+    # 在线查询：users 可重复，status 每条是 varint(长度) + 名字 + 1字节
+    print("\n--- 二进制在线查询 ---")
+    user1.sendall(pack_bin(5, [(F_CMD, CMD_PRESENCE), (F_USERS, "user2"), (F_USERS, "nobody")]))
+    body_fields = None
+    raw_type, body_len = struct.unpack('!II', recv_exact(user1, 8))
+    body_fields = decode(recv_exact(user1, body_len))
+    status = {}
+    for tag, value in body_fields:
+        if tag == F_STATUS:
+            name_len, pos = get_varint(value, 0)
+            status[value[pos:pos + name_len].decode('utf-8')] = bool(value[pos + name_len])
+    print("[user1] 在线状态 ->", status)
+    assert raw_type & BINARY_FLAG and status == {"user2": True, "nobody": False}
+
+    # 非法 UTF-8：群里有 JSON 成员，整条请求回 400，不推给任何人
+    print("\n--- 非法 UTF-8 文本 ---")
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_GROUP_CHAT), (F_GROUP_ID, 1), (F_MSG, b"bad \xff\xfe")]))
+    _, fmt, resp = recv_msg(user1)
+    print("[user1] 回执 ->", fmt, resp)
+    assert fmt == 'binary' and resp[F_CODE] == 400
+    # 过长编码和代理区也算非法
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_CHAT), (F_TO, "user3"), (F_MSG, b"\xc0\xaf \xed\xa0\x80")]))
+    _, fmt, resp = recv_msg(user1)
+    assert resp[F_CODE] == 400
+    # 之后正常的群聊照常送达 JSON 成员，前面的坏包没有漏过来
+    user1.sendall(pack_bin(2, [(F_CMD, CMD_GROUP_CHAT), (F_GROUP_ID, 1), (F_MSG, "after bad")]))
+    _, fmt, push = recv_msg(user3)
+    print("[user3] 收到 ->", fmt, push)
+    assert fmt == 'json' and push["msg"] == "after bad"
+    recv_msg(user2)
+    _, fmt, resp = recv_msg(user1)
+    assert resp[F_CODE] == 200
+
+    for sock in (user1, user2, user3):
+        sock.close()
+    print("\n二进制包体测试通过")
+
+if __name__ == '__main__':
+    run_client()
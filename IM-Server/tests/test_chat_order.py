@@ -0,0 +1,57 @@
+import socket
+import struct
+import json
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, json.loads(recv_exact(sock, body_len).decode('utf-8'))
+
+def login(username):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.connect(('127.0.0.1', 8080))
+    sock.sendall(pack_msg(1, {"cmd": "login", "username": username, "password": "123456"}))
+    print(f"[{username}] 登录回包 ->", recv_msg(sock))
+    return sock
+
+def run_client(count=500):
+    sender = login("user1")
+    receiver = login("user2")
+
+    # 一次性把所有消息塞进一个TCP包序列里，服务端同一连接的任务必须按顺序处理
+    print(f"\n--- user1 连发 {count} 条消息给 user2 ---")
+    batch = b''.join(pack_msg(2, {"cmd": "chat", "to": "user2", "msg": f"m{i}"})
+                     for i in range(count))
+    sender.sendall(batch)
+
+    got = []
+    while len(got) < count:
+        msg_type, push = recv_msg(receiver)
+        if push.get("cmd") == "push_chat":
+            got.append(push["msg"])
+    expected = [f"m{i}" for i in range(count)]
+    if got == expected:
+        print("顺序正确")
+    else:
+        first_bad = next(i for i in range(count) if got[i] != expected[i])
+        print(f"顺序错乱！第 {first_bad} 条收到 {got[first_bad]}")
+        raise SystemExit(1)
+
+    sender.close()
+    receiver.close()
+
+if __name__ == '__main__':
+    run_client()
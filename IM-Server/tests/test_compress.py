@@ -0,0 +1,139 @@
+import socket
+import struct
+import json
+
+# 压缩包：msg_type 带 1<<31 标志位，包体 = 4字节大端原始长度 + LZ4 块
+COMPRESSED_FLAG = 1 << 31
+FLAG_MASK = 0xFF000000
+
+def lz4_block_decompress(src, raw_len):
+    out = bytearray()
+    pos = 0
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            while True:
+                b = src[pos]
+                pos += 1
+                lit_len += b
+                if b != 255:
+                    break
+        out += src[pos:pos + lit_len]
+        pos += lit_len
+        if pos >= len(src):
+            break
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+        match_len = token & 0x0F
+        if match_len == 15:
+            while True:
+                b = src[pos]
+                pos += 1
+                match_len += b
+                if b != 255:
+                    break
+        match_len += 4
+        for _ in range(match_len):
+            out.append(out[-offset])
+    assert len(out) == raw_len
+    return bytes(out)
+
+# 只有字面量的 LZ4 块（合法但不压缩），用来测服务端的解压路径
+def lz4_block_literals(data):
+    n = len(data)
+    if n < 15:
+        return bytes([n << 4]) + data
+    out = bytes([0xF0])
+    rest = n - 15
+    while rest >= 255:
+        out += b'\xff'
+        rest -= 255
+    return out + bytes([rest]) + data
+
+def pack_msg(msg_type, content_dict, compress=False):
+    body = json.dumps(content_dict).encode('utf-8')
+    if compress:
+        body = struct.pack('!I', len(body)) + lz4_block_literals(body)
+        msg_type |= COMPRESSED_FLAG
+    return struct.pack('!II', msg_type, len(body)) + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+# 返回 (类型, 是否压缩, 线上包体长度, 解开后的JSON)
+def recv_msg(sock):
+    raw_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    body = recv_exact(sock, body_len)
+    compressed = bool(raw_type & COMPRESSED_FLAG)
+    if compressed:
+        raw_len = struct.unpack('!I', body[:4])[0]
+        body = lz4_block_decompress(body[4:], raw_len)
+    return raw_type & ~FLAG_MASK, compressed, body_len, json.loads(body.decode('utf-8'))
+
+def login(username, compress):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.connect(('127.0.0.1', 8080))
+    sock.sendall(pack_msg(1, {"cmd": "login", "username": username,
+                              "password": "123456", "compress": compress}))
+    resp = recv_msg(sock)
+    print(f"[{username}] 登录回包 ->", resp)
+    return sock, resp[3].get("compress") == 1
+
+def run_client():
+    user1, _ = login("user1", False)
+    user2, enabled = login("user2", True)
+    if not enabled:
+        print("服务端没有编入 LZ4，跳过压缩测试")
+        return
+
+    # 小消息低于阈值，不压缩
+    user1.sendall(pack_msg(2, {"cmd": "chat", "to": "user2", "msg": "short"}))
+    _, compressed, _, push = recv_msg(user2)
+    print("[user2] 小消息 ->", compressed, push)
+    assert not compressed and push["msg"] == "short"
+    recv_msg(user1)
+
+    # 大的群公告：对 user2 压缩，对没声明的 user1 原样发
+    print("\n--- 大消息 ---")
+    announcement = "系统公告：今晚 23:00 停机维护。" * 200
+    user1.sendall(pack_msg(2, {"cmd": "chat", "to": "user2", "msg": announcement}))
+    _, compressed, wire_len, push = recv_msg(user2)
+    print(f"[user2] 压缩={compressed} 线上 {wire_len} 字节，原文 {len(announcement.encode())} 字节")
+    assert compressed and push["msg"] == announcement and wire_len < len(announcement.encode()) // 4
+    _, compressed, _, resp = recv_msg(user1)
+    assert not compressed and resp["code"] == 200
+
+    # 客户端发压缩包，服务端解开后照常处理
+    print("\n--- 上行压缩包 ---")
+    user2.sendall(pack_msg(2, {"cmd": "chat", "to": "user1", "msg": "x" * 1000}, compress=True))
+    _, compressed, _, push = recv_msg(user1)
+    print("[user1] 收到 ->", compressed, len(push["msg"]))
+    assert not compressed and push["msg"] == "x" * 1000
+    _, _, _, resp = recv_msg(user2)
+    assert resp["code"] == 200
+
+    # 坏的压缩包直接断开
+    print("\n--- 坏压缩包 ---")
+    bad = struct.pack('!I', 100) + b'\xff\xff\xff'
+    user2.sendall(struct.pack('!II', 2 | COMPRESSED_FLAG, len(bad)) + bad)
+    try:
+        data = user2.recv(1)
+    except ConnectionError:
+        data = b''
+    assert data == b''
+    print("连接已被服务端关闭")
+
+    user1.close()
+    user2.close()
+    print("\n压缩测试通过")
+
+if __name__ == '__main__':
+    run_client()
@@ -0,0 +1,232 @@
+import json
+import os
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+# 平滑重启：旧进程在跑的时候再起一个新进程，新进程预热完从旧进程领走监听socket，
+# 旧进程停止 accept，在 upgrade.drain_timeout 秒内分批关掉已有连接后退出。
+# 交接默认关闭，先在 server.json 里把 upgrade.socket_path 设成服务账号私有目录下的路径
+# （例如 /run/im_server/upgrade.sock，测试时可以用 $XDG_RUNTIME_DIR 下的）。
+# 用法：先在 tests 目录下照常启动 im_server，再运行
+#   IM_SERVER=<im_server 路径> python3 test_handover.py
+# 统计：重启期间新建连接失败数（应为 0）、已有连接被关后的重连情况、
+#       每秒重连数峰值、新旧进程每秒 CPU 占用峰值。
+# 前几条长连接登录，重连后重新登录；旧进程退出后检查这些用户在 Redis 里还是在线
+# 跑完之后新进程留着继续服务，pid 会打印出来
+IM_SERVER = os.environ.get("IM_SERVER", "../build/im_server")
+CLIENTS = 100
+PING_INTERVAL = 0.2
+PROBE_INTERVAL = 0.02
+USERS = ["user1", "user2", "user3"]
+REDIS_ADDR = ('127.0.0.1', 6379)
+CLK_TCK = os.sysconf("SC_CLK_TCK")
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, recv_exact(sock, body_len)
+
+def ping(sock):
+    sock.sendall(pack_msg(3, {"cmd": "ping"}))
+    # 登录后可能先收到离线消息推送，跳过
+    while recv_msg(sock)[0] != 4:
+        pass
+
+def login(sock, user):
+    sock.sendall(pack_msg(1, {"cmd": "login", "username": user,
+                              "password": "123456"}))
+    msg_type, body = recv_msg(sock)
+    assert msg_type == 1 and json.loads(body)["code"] == 200, body
+
+def redis_online(user):
+    # 直接说 RESP，不依赖 redis 客户端库
+    key = f"online:user:{user}".encode()
+    with socket.create_connection(REDIS_ADDR, timeout=5) as sock:
+        sock.sendall(b"*2\r\n$6\r\nEXISTS\r\n$%d\r\n%s\r\n" % (len(key), key))
+        return sock.recv(64).startswith(b":1")
+
+def connect():
+    sock = socket.create_connection(('127.0.0.1', 8080), timeout=5)
+    sock.settimeout(5)
+    return sock
+
+def server_pids():
+    pids = []
+    for entry in os.listdir('/proc'):
+        if not entry.isdigit():
+            continue
+        try:
+            with open(f'/proc/{entry}/comm') as f:
+                if f.read().strip() == 'im_server':
+                    pids.append(int(entry))
+        except OSError:
+            pass
+    return pids
+
+def cpu_ticks(pid):
+    try:
+        with open(f'/proc/{pid}/stat') as f:
+            fields = f.read().rsplit(')', 1)[1].split()
+        return int(fields[11]) + int(fields[12])
+    except OSError:
+        return None
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.probe_ok = 0
+        self.probe_failed = 0
+        self.reconnects = []      # 每次重连成功的时间
+        self.reconnect_failed = 0
+
+def client_loop(stats, stop, user=None):
+    sock = connect()
+    if user:
+        login(sock, user)
+    while not stop.is_set():
+        try:
+            ping(sock)
+            time.sleep(PING_INTERVAL)
+            continue
+        except (ConnectionError, OSError):
+            pass
+        # 被旧进程关掉了，重连到新进程
+        sock.close()
+        try:
+            sock = connect()
+            if user:
+                login(sock, user)
+            with stats.lock:
+                stats.reconnects.append(time.time())
+        except OSError:
+            with stats.lock:
+                stats.reconnect_failed += 1
+            time.sleep(0.1)
+            sock = connect()
+            if user:
+                login(sock, user)
+    sock.close()
+
+def probe_loop(stats, stop):
+    # 一直新建短连接，看重启过程中有没有建连失败或者连上没人理
+    while not stop.is_set():
+        try:
+            sock = connect()
+            ping(sock)
+            sock.close()
+            with stats.lock:
+                stats.probe_ok += 1
+        except (ConnectionError, OSError) as e:
+            with stats.lock:
+                stats.probe_failed += 1
+            print("新建连接失败:", e)
+        time.sleep(PROBE_INTERVAL)
+
+def cpu_loop(pids, peaks, stop):
+    last = {pid: cpu_ticks(pid) for pid in pids}
+    while not stop.wait(1.0):
+        for pid in pids:
+            now = cpu_ticks(pid)
+            if now is None or last[pid] is None:
+                continue
+            percent = (now - last[pid]) * 100.0 / CLK_TCK
+            peaks[pid] = max(peaks.get(pid, 0.0), percent)
+            last[pid] = now
+
+def run():
+    with open('../conf/server.json') as f:
+        upgrade = json.load(f).get('upgrade', {})
+    if not upgrade.get('socket_path'):
+        print("server.json 里没有配置 upgrade.socket_path（默认关闭平滑重启）")
+        sys.exit(1)
+    drain_timeout = upgrade.get('drain_timeout', 30)
+    old_pids = server_pids()
+    if len(old_pids) != 1:
+        print("需要先启动一个 im_server，现在有:", old_pids)
+        sys.exit(1)
+    old_pid = old_pids[0]
+
+    stats = Stats()
+    stop = threading.Event()
+    threads = [threading.Thread(target=client_loop,
+                                args=(stats, stop,
+                                      USERS[i] if i < len(USERS) else None))
+               for i in range(CLIENTS)]
+    threads.append(threading.Thread(target=probe_loop, args=(stats, stop)))
+    for t in threads:
+        t.daemon = True
+        t.start()
+    time.sleep(1)
+    print(f"旧进程 {old_pid}，{CLIENTS} 条长连接在 ping，另有一路一直新建短连接")
+
+    start = time.time()
+    new = subprocess.Popen([IM_SERVER], stdout=subprocess.DEVNULL,
+                           stderr=subprocess.STDOUT)
+    peaks = {}
+    cpu_stop = threading.Event()
+    cpu_thread = threading.Thread(target=cpu_loop,
+                                  args=([old_pid, new.pid], peaks, cpu_stop))
+    cpu_thread.daemon = True
+    cpu_thread.start()
+    print(f"启动新进程 {new.pid}，等旧进程排空退出（最多 {drain_timeout}s）")
+
+    deadline = time.time() + drain_timeout + 15
+    while os.path.exists(f'/proc/{old_pid}') and time.time() < deadline:
+        if new.poll() is not None:
+            print("新进程提前退出了，见 app.log")
+            sys.exit(1)
+        try:
+            # 旧进程是测试外面起的，退出后会留下僵尸，看状态
+            with open(f'/proc/{old_pid}/stat') as f:
+                if f.read().rsplit(')', 1)[1].split()[0] == 'Z':
+                    break
+        except OSError:
+            break
+        time.sleep(0.2)
+    old_exited = time.time() - start
+    time.sleep(2)
+    # 旧进程排空时不能把已经重连到新进程的用户在 Redis 里标成下线
+    offline = [user for user in USERS if not redis_online(user)]
+    stop.set()
+    cpu_stop.set()
+    for t in threads:
+        t.join(timeout=10)
+
+    with stats.lock:
+        per_second = {}
+        for t in stats.reconnects:
+            per_second[int(t - start)] = per_second.get(int(t - start), 0) + 1
+        print(f"\n旧进程 {old_exited:.1f}s 后退出")
+        print(f"新建短连接: 成功 {stats.probe_ok}, 失败 {stats.probe_failed}")
+        print(f"长连接重连: 成功 {len(stats.reconnects)}, "
+              f"失败 {stats.reconnect_failed}, "
+              f"每秒峰值 {max(per_second.values()) if per_second else 0}")
+        print(f"CPU 每秒峰值: 旧进程 {peaks.get(old_pid, 0):.0f}%, "
+              f"新进程 {peaks.get(new.pid, 0):.0f}%")
+        assert old_exited < drain_timeout + 15, "旧进程没有按时退出"
+        assert stats.probe_failed == 0, "重启期间有新建连接失败"
+        assert stats.reconnect_failed == 0, "有长连接重连失败"
+        assert len(stats.reconnects) >= CLIENTS, "有长连接没有被迁到新进程"
+    print("重连后 Redis 里显示下线的用户:", offline)
+    assert not offline, "旧进程排空后把重连的用户标成了下线"
+    print(f"\n平滑重启测试通过，新进程 {new.pid} 继续服务")
+
+if __name__ == '__main__':
+    run()
@@ -0,0 +1,95 @@
+import json
+import socket
+import struct
+import sys
+import urllib.error
+import urllib.request
+
+# 指标端口：抓一次，ping/登录一轮后再抓一次，看计数有没有跟着涨。
+# 指标端口默认关闭，先在 server.json 里把 admin.port 设成例如 9100
+with open('../conf/server.json') as f:
+    ADMIN = json.load(f).get('admin', {})
+METRICS_URL = "http://%s:%d/metrics" % (ADMIN.get('ip', '127.0.0.1'),
+                                        ADMIN.get('port', 0))
+PINGS = 20
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, json.loads(recv_exact(sock, body_len).decode('utf-8'))
+
+def scrape():
+    with urllib.request.urlopen(METRICS_URL, timeout=5) as resp:
+        assert resp.status == 200
+        assert resp.headers['Content-Type'].startswith('text/plain')
+        text = resp.read().decode('utf-8')
+    samples = {}
+    for line in text.splitlines():
+        if not line or line.startswith('#'):
+            continue
+        name, value = line.rsplit(' ', 1)
+        samples[name] = float(value)
+    return samples
+
+def total(samples, prefix):
+    # 各 loop 的同名序列加起来
+    return sum(v for k, v in samples.items()
+               if k == prefix or k.startswith(prefix + '{'))
+
+def run_client():
+    if not ADMIN.get('port'):
+        print("server.json 里 admin.port 为 0（默认关闭指标端口）")
+        sys.exit(1)
+    before = scrape()
+    client = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    client.connect(('127.0.0.1', 8080))
+    client.sendall(pack_msg(1, {"cmd": "login", "username": "user1", "password": "123456"}))
+    print("登录回包 ->", recv_msg(client))
+    for _ in range(PINGS):
+        client.sendall(pack_msg(3, {"cmd": "ping"}))
+        assert recv_msg(client)[0] == 4
+    during = scrape()
+    client.close()
+
+    checks = [
+        ('im_accepted_connections_total', 1),
+        ('im_frames_received_total{msg_type="3"}', PINGS),
+        ('im_frames_received_total{msg_type="1"}', 1),
+        ('im_frames_in_total', PINGS + 1),
+        ('im_bytes_in_total', 1),
+        ('im_bytes_out_total', 1),
+        ('im_threadpool_wait_seconds_count{pool="blocking"}', 1),
+    ]
+    for name, at_least in checks:
+        grown = total(during, name) - total(before, name)
+        print(f"{name}: +{grown:.0f}")
+        assert grown >= at_least, name
+    live = total(during, 'im_live_connections')
+    print("当前连接数:", live)
+    assert live >= 1
+    print("登录 check_user p99 (s):",
+          during.get('im_mysql_call_seconds_quantile{op="check_user",quantile="0.99"}'))
+
+    # 其他路径 404
+    try:
+        urllib.request.urlopen(METRICS_URL.replace('/metrics', '/nope'), timeout=5)
+        assert False, "应该返回 404"
+    except urllib.error.HTTPError as e:
+        assert e.code == 404
+    print("\n指标端口测试通过")
+
+if __name__ == '__main__':
+    run_client()
@@ -0,0 +1,48 @@
+import socket
+import struct
+import json
+
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, json.loads(recv_exact(sock, body_len).decode('utf-8'))
+
+def run_client():
+    # user1 登录，user2 不登录
+    client = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    client.connect(('127.0.0.1', 8080))
+    client.sendall(pack_msg(1, {"cmd": "login", "username": "user1", "password": "123456"}))
+    print("登录回包 ->", recv_msg(client))
+
+    # type 5 在线查询，在IO线程上直接回包
+    print("\n--- 查询在线状态 ---")
+    client.sendall(pack_msg(5, {"cmd": "presence", "users": ["user1", "user2"]}))
+    msg_type, resp = recv_msg(client)
+    print(f"服务端响应 -> Type: {msg_type}, Data: {resp}")
+    assert msg_type == 5 and resp["status"] == {"user1": True, "user2": False}
+
+    # 超过上限的查询被拒绝
+    print("\n--- 查询人数超限 ---")
+    client.sendall(pack_msg(5, {"cmd": "presence", "users": ["u%d" % i for i in range(300)]}))
+    msg_type, resp = recv_msg(client)
+    print(f"服务端响应 -> Type: {msg_type}, Data: {resp}")
+    assert resp["code"] == 400
+
+    client.close()
+    print("\n在线查询测试通过")
+
+if __name__ == '__main__':
+    run_client()
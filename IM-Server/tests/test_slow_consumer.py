@@ -0,0 +1,74 @@
+import socket
+import struct
+import json
+import time
+
+# 慢消费者：user2 登录后不读，user1 往群里猛发大消息。
+# 默认策略 drop_oldest：服务端给 user2 攒的群聊推送超过高水位后丢掉老的，
+# user1 的回执不受影响，user2 恢复读以后连接仍然可用
+def pack_msg(msg_type, content_dict):
+    body = json.dumps(content_dict).encode('utf-8')
+    header = struct.pack('!II', msg_type, len(body))
+    return header + body
+
+def recv_exact(sock, n):
+    data = b''
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("服务端断开")
+        data += chunk
+    return data
+
+def recv_msg(sock):
+    msg_type, body_len = struct.unpack('!II', recv_exact(sock, 8))
+    return msg_type, json.loads(recv_exact(sock, body_len).decode('utf-8'))
+
+def login(username, rcvbuf=None):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    if rcvbuf:
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, rcvbuf)
+    sock.connect(('127.0.0.1', 8080))
+    sock.sendall(pack_msg(1, {"cmd": "login", "username": username, "password": "123456"}))
+    print(f"[{username}] 登录回包 ->", recv_msg(sock))
+    return sock
+
+def run_client(count=400, size=32 * 1024):
+    sender = login("user1")
+    slow = login("user2", rcvbuf=64 * 1024)
+
+    print(f"\n--- user1 往群里发 {count} 条 {size // 1024}KB 的消息，user2 不读 ---")
+    payload = "x" * size
+    start = time.time()
+    for i in range(count):
+        sender.sendall(pack_msg(2, {"cmd": "group_chat", "group_id": 1, "msg": f"{i}:{payload}"}))
+        _, resp = recv_msg(sender)
+        assert resp["code"] == 200, resp
+    print(f"user1 的 {count} 条回执全部收到，用时 {time.time() - start:.2f}s")
+
+    # user2 开始读：收到的推送少于发出的，而且剩下的仍然按顺序
+    slow.settimeout(3)
+    received = []
+    try:
+        while True:
+            _, push = recv_msg(slow)
+            received.append(int(push["msg"].split(":", 1)[0]))
+    except socket.timeout:
+        pass
+    print(f"user2 收到 {len(received)} / {count} 条群聊推送")
+    assert 0 < len(received) < count
+    assert received == sorted(received)
+
+    # 连接还活着
+    slow.settimeout(5)
+    slow.sendall(pack_msg(3, {}))
+    msg_type, resp = recv_msg(slow)
+    print("user2 ping ->", msg_type, resp)
+    assert msg_type == 4
+
+    sender.close()
+    slow.close()
+    print("\n慢消费者测试通过")
+
+if __name__ == '__main__':
+    run_client()